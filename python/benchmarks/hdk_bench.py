@@ -0,0 +1,396 @@
+#!/usr/bin/env python3
+
+#
+# Copyright 2022 Intel Corporation.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""
+Benchmark runner for HDK. Generates synthetic data, imports it into
+ArrowStorage and runs Modin-style and TPC-H-style queries through Calcite
+and RelAlgExecutor. Results are written as JSON to compare them between
+commits.
+"""
+
+import argparse
+import datetime
+import json
+import platform
+import resource
+import statistics
+import subprocess
+import sys
+import time
+
+import numpy as np
+import pyarrow
+import pyhdk
+
+MODIN_QUERIES = {
+    "filter": """
+        SELECT COUNT(*) AS cnt FROM trips
+        WHERE fare_amount > 50 AND passenger_count = 2;
+    """,
+    "projection": """
+        SELECT fare_amount + tip_amount AS total, trip_distance * 1.609 AS km
+        FROM trips;
+    """,
+    "groupby": """
+        SELECT passenger_count, COUNT(*) AS cnt, AVG(fare_amount) AS avg_fare,
+               SUM(trip_distance) AS dist
+        FROM trips GROUP BY passenger_count;
+    """,
+    "groupby_high_cardinality": """
+        SELECT pickup_zone, COUNT(*) AS cnt, MAX(tip_amount) AS max_tip
+        FROM trips GROUP BY pickup_zone;
+    """,
+    "sort": """
+        SELECT trip_id, fare_amount FROM trips
+        ORDER BY fare_amount DESC, trip_id LIMIT 100;
+    """,
+    "join": """
+        SELECT v.vendor_name, COUNT(*) AS cnt, AVG(t.fare_amount) AS avg_fare
+        FROM trips t JOIN vendors v ON t.vendor_id = v.vendor_id
+        GROUP BY v.vendor_name;
+    """,
+}
+
+TPCH_QUERIES = {
+    "tpch_q1": """
+        SELECT l_returnflag, l_linestatus,
+               SUM(l_quantity) AS sum_qty,
+               SUM(l_extendedprice) AS sum_base_price,
+               SUM(l_extendedprice * (1 - l_discount)) AS sum_disc_price,
+               SUM(l_extendedprice * (1 - l_discount) * (1 + l_tax)) AS sum_charge,
+               AVG(l_quantity) AS avg_qty,
+               AVG(l_extendedprice) AS avg_price,
+               AVG(l_discount) AS avg_disc,
+               COUNT(*) AS count_order
+        FROM lineitem
+        WHERE l_shipdate <= DATE '1998-09-02'
+        GROUP BY l_returnflag, l_linestatus
+        ORDER BY l_returnflag, l_linestatus;
+    """,
+    "tpch_q3": """
+        SELECT l_orderkey, SUM(l_extendedprice * (1 - l_discount)) AS revenue,
+               o_orderdate, o_shippriority
+        FROM customer, orders, lineitem
+        WHERE c_mktsegment = 'BUILDING'
+          AND c_custkey = o_custkey
+          AND l_orderkey = o_orderkey
+          AND o_orderdate < DATE '1995-03-15'
+          AND l_shipdate > DATE '1995-03-15'
+        GROUP BY l_orderkey, o_orderdate, o_shippriority
+        ORDER BY revenue DESC, o_orderdate
+        LIMIT 10;
+    """,
+    "tpch_q6": """
+        SELECT SUM(l_extendedprice * l_discount) AS revenue
+        FROM lineitem
+        WHERE l_shipdate >= DATE '1994-01-01'
+          AND l_shipdate < DATE '1995-01-01'
+          AND l_discount BETWEEN 0.05 AND 0.07
+          AND l_quantity < 24;
+    """,
+}
+
+# Input tables of each query used to compute the processing rate.
+QUERY_TABLES = {
+    "filter": ["trips"],
+    "projection": ["trips"],
+    "groupby": ["trips"],
+    "groupby_high_cardinality": ["trips"],
+    "sort": ["trips"],
+    "join": ["trips", "vendors"],
+    "tpch_q1": ["lineitem"],
+    "tpch_q3": ["customer", "orders", "lineitem"],
+    "tpch_q6": ["lineitem"],
+}
+
+
+def _strings(rng, values, size):
+    indices = pyarrow.array(rng.integers(0, len(values), size, dtype=np.int32))
+    return pyarrow.DictionaryArray.from_arrays(
+        indices, pyarrow.array(values)
+    ).dictionary_decode()
+
+
+def _dates(rng, start, end, size):
+    start_days = (datetime.date.fromisoformat(start) - datetime.date(1970, 1, 1)).days
+    end_days = (datetime.date.fromisoformat(end) - datetime.date(1970, 1, 1)).days
+    days = rng.integers(start_days, end_days, size, dtype=np.int32)
+    return pyarrow.array(days).cast(pyarrow.date32())
+
+
+def generate_tables(scale, seed):
+    """
+    Generate tables for the benchmark queries. Scale 1 means 1M rows in
+    the trips and lineitem tables.
+    """
+    rng = np.random.default_rng(seed)
+    rows = max(int(scale * 1_000_000), 1)
+    tables = {}
+
+    num_vendors = 100
+    tables["trips"] = pyarrow.table(
+        {
+            "trip_id": np.arange(rows, dtype=np.int64),
+            "vendor_id": rng.integers(0, num_vendors, rows, dtype=np.int32),
+            "passenger_count": rng.integers(1, 7, rows, dtype=np.int16),
+            "pickup_zone": rng.integers(0, 10000, rows, dtype=np.int32),
+            "trip_distance": rng.exponential(3.0, rows),
+            "fare_amount": rng.exponential(15.0, rows),
+            "tip_amount": rng.exponential(2.0, rows),
+        }
+    )
+    tables["vendors"] = pyarrow.table(
+        {
+            "vendor_id": np.arange(num_vendors, dtype=np.int32),
+            "vendor_name": [f"vendor_{i % 10}" for i in range(num_vendors)],
+        }
+    )
+
+    num_customers = max(rows // 40, 1)
+    num_orders = max(rows // 4, 1)
+    tables["customer"] = pyarrow.table(
+        {
+            "c_custkey": np.arange(num_customers, dtype=np.int64),
+            "c_mktsegment": _strings(
+                rng,
+                ["AUTOMOBILE", "BUILDING", "FURNITURE", "HOUSEHOLD", "MACHINERY"],
+                num_customers,
+            ),
+        }
+    )
+    tables["orders"] = pyarrow.table(
+        {
+            "o_orderkey": np.arange(num_orders, dtype=np.int64),
+            "o_custkey": rng.integers(0, num_customers, num_orders, dtype=np.int64),
+            "o_orderdate": _dates(rng, "1992-01-01", "1998-08-02", num_orders),
+            "o_shippriority": np.zeros(num_orders, dtype=np.int32),
+        }
+    )
+    tables["lineitem"] = pyarrow.table(
+        {
+            "l_orderkey": np.sort(rng.integers(0, num_orders, rows, dtype=np.int64)),
+            "l_quantity": rng.integers(1, 51, rows).astype(np.float64),
+            "l_extendedprice": rng.uniform(900.0, 105000.0, rows),
+            "l_discount": rng.integers(0, 11, rows) / 100.0,
+            "l_tax": rng.integers(0, 9, rows) / 100.0,
+            "l_returnflag": _strings(rng, ["A", "N", "R"], rows),
+            "l_linestatus": _strings(rng, ["F", "O"], rows),
+            "l_shipdate": _dates(rng, "1992-01-02", "1998-12-01", rows),
+        }
+    )
+    return tables
+
+
+def _elapsed_ms(start):
+    return (time.perf_counter() - start) * 1000.0
+
+
+def _positive_int(value):
+    res = int(value)
+    if res < 1:
+        raise argparse.ArgumentTypeError(f"expected a positive integer, got {value}")
+    return res
+
+
+# Engine timer wrapping code generation and JIT compilation of a work unit.
+CODEGEN_TIMER = "compileWorkUnit"
+
+
+def _codegen_ms(node):
+    """
+    Sum durations of code generation timers in the engine timers tree.
+    Nested code generation timers are not counted twice.
+    """
+    if isinstance(node, list):
+        return sum(_codegen_ms(child) for child in node)
+    if not isinstance(node, dict):
+        return 0.0
+    if node.get("name") == CODEGEN_TIMER:
+        return node.get("duration_ms", 0.0)
+    return sum(_codegen_ms(child) for child in node.values())
+
+
+def _git_revision():
+    try:
+        return subprocess.check_output(
+            ["git", "rev-parse", "HEAD"], stderr=subprocess.DEVNULL, text=True
+        ).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+class Benchmark:
+    def __init__(self, args):
+        self.args = args
+        self.storage = pyhdk.storage.ArrowStorage(1)
+        self.data_mgr = pyhdk.storage.DataMgr()
+        self.data_mgr.registerDataProvider(self.storage)
+        self.calcite = pyhdk.sql.Calcite(self.storage)
+        self.executor = pyhdk.Executor(self.data_mgr)
+        # Ids of Executors created to measure code generation time.
+        self.next_executor_id = 1
+        self.table_rows = {}
+
+    def import_tables(self, tables):
+        res = {}
+        opt = pyhdk.storage.TableOptions(self.args.fragment_size)
+        for name, table in tables.items():
+            start = time.perf_counter()
+            self.storage.importArrowTable(table, name, opt)
+            import_ms = _elapsed_ms(start)
+            self.table_rows[name] = table.num_rows
+            res[name] = {
+                "rows": table.num_rows,
+                "bytes": table.nbytes,
+                "import_ms": import_ms,
+            }
+        return res
+
+    def run_once(self, sql, executor=None):
+        start = time.perf_counter()
+        ra = self.calcite.process(sql)
+        calcite_ms = _elapsed_ms(start)
+        rel_alg_executor = pyhdk.sql.RelAlgExecutor(
+            executor or self.executor, self.storage, self.data_mgr, ra
+        )
+        res = rel_alg_executor.execute(enable_columnar_output=self.args.columnar_output)
+        res.to_arrow()
+        total_ms = _elapsed_ms(start)
+
+        profile = dict(res.profile)
+        profile["calcite_ms"] = calcite_ms
+        profile["total_ms"] = total_ms
+        return profile
+
+    def measure_codegen_ms(self, sql):
+        """
+        Run the query with engine timers enabled on a fresh Executor, which
+        has an empty code cache, and return its code generation time.
+        """
+        executor = pyhdk.Executor(self.data_mgr, self.next_executor_id)
+        self.next_executor_id += 1
+        pyhdk.setGlobalConfig(enable_debug_timer=True)
+        try:
+            profile = self.run_once(sql, executor)
+        finally:
+            pyhdk.setGlobalConfig(enable_debug_timer=False)
+        return _codegen_ms(profile["timers"]) if "timers" in profile else None
+
+    def run_query(self, name, sql):
+        # The first run includes code generation and compilation of kernels,
+        # next runs reuse kernels from the Executor's code cache. Timers would
+        # slow the measured runs down, so code generation time is taken from a
+        # separate run.
+        cold = self.run_once(sql)
+        warm = [self.run_once(sql) for _ in range(self.args.iterations)]
+        codegen_ms = self.measure_codegen_ms(sql)
+
+        def median(key):
+            return statistics.median(profile[key] for profile in warm)
+
+        warm_ms = median("total_ms")
+        execution_ms = median("execution_ms")
+        arrow_conversion_ms = median("arrow_conversion_ms")
+        input_rows = sum(self.table_rows[table] for table in QUERY_TABLES[name])
+        return {
+            "cold_ms": cold["total_ms"],
+            "warm_ms": warm_ms,
+            "warm_min_ms": min(profile["total_ms"] for profile in warm),
+            "calcite_ms": median("calcite_ms"),
+            "dag_build_ms": median("dag_build_ms"),
+            "execution_ms": execution_ms,
+            "codegen_ms": codegen_ms,
+            # Besides code generation, the first run of a query fetches data
+            # of tables not used by previous queries into the buffer pool.
+            "first_run_overhead_ms": max(cold["execution_ms"] - execution_ms, 0.0),
+            "arrow_conversion_ms": arrow_conversion_ms,
+            "arrow_export_mb_per_s": (
+                cold["arrow_bytes"] / 1e6 / (arrow_conversion_ms / 1000.0)
+                if arrow_conversion_ms > 0
+                else None
+            ),
+            "peak_rss_mb": max(profile["peak_rss_mb"] for profile in [cold] + warm),
+            "input_rows": input_rows,
+            "rows_per_s": input_rows / (warm_ms / 1000.0) if warm_ms > 0 else None,
+            "result_rows": cold.get("result_rows"),
+        }
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument(
+        "--scale",
+        type=float,
+        default=1.0,
+        help="data scale, 1 means 1M rows in the largest tables",
+    )
+    parser.add_argument("--fragment-size", type=int, default=32_000_000)
+    parser.add_argument(
+        "--iterations",
+        type=_positive_int,
+        default=5,
+        help="number of warm runs per query",
+    )
+    parser.add_argument(
+        "--queries",
+        nargs="*",
+        help="names of queries to run, all queries are run by default",
+    )
+    parser.add_argument("--columnar-output", action="store_true")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--output", help="output JSON file, stdout by default")
+    args = parser.parse_args(argv)
+
+    queries = {**MODIN_QUERIES, **TPCH_QUERIES}
+    if args.queries:
+        unknown = set(args.queries) - queries.keys()
+        if unknown:
+            parser.error(f"unknown queries: {', '.join(sorted(unknown))}")
+        queries = {name: queries[name] for name in args.queries}
+
+    pyhdk.initLogger()
+    bench = Benchmark(args)
+    start = time.perf_counter()
+    tables = generate_tables(args.scale, args.seed)
+    generation_ms = _elapsed_ms(start)
+    import_stats = bench.import_tables(tables)
+    del tables
+
+    results = {}
+    for name, sql in queries.items():
+        print(f"Running {name}...", file=sys.stderr)
+        results[name] = bench.run_query(name, sql)
+
+    report = {
+        "revision": _git_revision(),
+        "timestamp": datetime.datetime.now().isoformat(),
+        "platform": platform.platform(),
+        "python": platform.python_version(),
+        "config": {
+            "scale": args.scale,
+            "fragment_size": args.fragment_size,
+            "iterations": args.iterations,
+            "columnar_output": args.columnar_output,
+            "seed": args.seed,
+        },
+        "data_generation_ms": generation_ms,
+        "tables": import_stats,
+        "queries": results,
+        # ru_maxrss is reported in kilobytes on Linux.
+        "peak_rss_mb": resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024.0,
+    }
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=2)
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == "__main__":
+    main()
@@ -18,6 +18,7 @@ from pyhdk._common import TypeInfo, SQLType, setGlobalConfig, initLogger
 from pyhdk._execute import Executor
 import pyhdk.sql as sql
 import pyhdk.storage as storage
+import pyhdk.builder as builder
 
 if sys.platform == "linux":
     sys.setdlopenflags(prev)
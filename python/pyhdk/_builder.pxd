@@ -0,0 +1,95 @@
+#
+# Copyright 2022 Intel Corporation.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+from libc.stdint cimport int64_t
+from libcpp cimport bool
+from libcpp.memory cimport unique_ptr
+from libcpp.string cimport string
+from libcpp.vector cimport vector
+
+from pyhdk._common cimport CSQLTypeInfo
+from pyhdk._storage cimport CSchemaProviderPtr
+from pyhdk._sql cimport CRelAlgDag
+
+cdef extern from "omniscidb/Shared/sqldefs.h":
+  enum CJoinType "JoinType":
+    INNER "JoinType::INNER",
+    LEFT "JoinType::LEFT",
+
+cdef extern from "src/QueryBuilder/QueryBuilder.h":
+  cdef cppclass CBuilderExpr "hdk::BuilderExpr":
+    CBuilderExpr()
+    CBuilderExpr(const CBuilderExpr&)
+
+    const string& name()
+    const CSQLTypeInfo& type()
+    bool isAggregate()
+
+    CBuilderExpr rename(const string&) except +
+
+    CBuilderExpr eq(const CBuilderExpr&) except +
+    CBuilderExpr ne(const CBuilderExpr&) except +
+    CBuilderExpr lt(const CBuilderExpr&) except +
+    CBuilderExpr le(const CBuilderExpr&) except +
+    CBuilderExpr gt(const CBuilderExpr&) except +
+    CBuilderExpr ge(const CBuilderExpr&) except +
+    CBuilderExpr logicalAnd(const CBuilderExpr&) except +
+    CBuilderExpr logicalOr(const CBuilderExpr&) except +
+    CBuilderExpr logicalNot() except +
+    CBuilderExpr isNull() except +
+    CBuilderExpr isNotNull() except +
+
+    CBuilderExpr add(const CBuilderExpr&) except +
+    CBuilderExpr sub(const CBuilderExpr&) except +
+    CBuilderExpr mul(const CBuilderExpr&) except +
+    CBuilderExpr div(const CBuilderExpr&) except +
+    CBuilderExpr mod(const CBuilderExpr&) except +
+    CBuilderExpr cast(const CSQLTypeInfo&) except +
+
+    CBuilderExpr count(bool) except +
+    CBuilderExpr sum() except +
+    CBuilderExpr avg() except +
+    CBuilderExpr min() except +
+    CBuilderExpr max() except +
+
+  CBuilderExpr CCstInt "hdk::BuilderExpr::cst"(int64_t)
+  CBuilderExpr CCstFp "hdk::BuilderExpr::cst"(double)
+  CBuilderExpr CCstBool "hdk::BuilderExpr::cst"(bool)
+  CBuilderExpr CCstStr "hdk::BuilderExpr::cst"(const string&)
+  CBuilderExpr CNullCst "hdk::BuilderExpr::nullCst"(const CSQLTypeInfo&)
+  CBuilderExpr CCountStar "hdk::BuilderExpr::countStar"()
+
+  cdef cppclass CBuilderSortField "hdk::BuilderSortField":
+    CBuilderSortField(const CBuilderExpr&, bool, bool)
+
+  cdef cppclass CBuilderNode "hdk::BuilderNode":
+    CBuilderNode()
+    CBuilderNode(const CBuilderNode&)
+
+    size_t size() except +
+    const vector[string]& fieldNames() except +
+    CBuilderExpr ref(size_t) except +
+    CBuilderExpr refByName "ref"(const string&) except +
+
+    CBuilderNode proj(const vector[CBuilderExpr]&) except +
+    CBuilderNode filter(const CBuilderExpr&) except +
+    CBuilderNode agg(const vector[CBuilderExpr]&, const vector[CBuilderExpr]&) except +
+    CBuilderNode sort(const vector[CBuilderSortField]&, size_t, size_t) except +
+    CBuilderNode join(const CBuilderNode&, const CBuilderExpr&, CJoinType) except +
+
+  cdef cppclass CQueryBuilder "hdk::QueryBuilder":
+    CQueryBuilder(CSchemaProviderPtr, int)
+
+    CBuilderNode scan(const string&) except +
+    unique_ptr[CRelAlgDag] finalize(const CBuilderNode&) except +
+
+cdef class BuilderExpr:
+  cdef CBuilderExpr c_expr
+
+cdef class BuilderNode:
+  cdef CBuilderNode c_node
+
+cdef class QueryBuilder:
+  cdef unique_ptr[CQueryBuilder] c_builder
@@ -0,0 +1,249 @@
+#
+# Copyright 2022 Intel Corporation.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+from libcpp.memory cimport make_unique
+from libcpp.utility cimport move
+
+import time
+
+from pyhdk._common cimport TypeInfo
+from pyhdk._storage cimport SchemaProvider
+from pyhdk._sql cimport RelAlgDag
+
+cdef BuilderExpr _wrap_expr(CBuilderExpr c_expr):
+  cdef BuilderExpr res = BuilderExpr()
+  res.c_expr = c_expr
+  return res
+
+cdef BuilderNode _wrap_node(CBuilderNode c_node):
+  cdef BuilderNode res = BuilderNode()
+  res.c_node = c_node
+  return res
+
+def cst(value):
+  if isinstance(value, BuilderExpr):
+    return value
+  if value is True or value is False:
+    return _wrap_expr(CCstBool(value))
+  if isinstance(value, int):
+    return _wrap_expr(CCstInt(value))
+  if isinstance(value, float):
+    return _wrap_expr(CCstFp(value))
+  if isinstance(value, str):
+    return _wrap_expr(CCstStr(value))
+  raise TypeError(f"Unsupported literal type: {type(value)}. Use nullCst for NULL literals.")
+
+def nullCst(TypeInfo type_info):
+  return _wrap_expr(CNullCst(type_info.c_type_info))
+
+def countStar():
+  return _wrap_expr(CCountStar())
+
+cdef CBuilderExpr _expr(value) except *:
+  return (<BuilderExpr>cst(value)).c_expr
+
+cdef class BuilderExpr:
+  @property
+  def name(self):
+    return self.c_expr.name()
+
+  @property
+  def type(self):
+    cdef TypeInfo res = TypeInfo()
+    res.c_type_info = self.c_expr.type()
+    return res
+
+  def isAggregate(self):
+    return self.c_expr.isAggregate()
+
+  def rename(self, string name):
+    return _wrap_expr(self.c_expr.rename(name))
+
+  def __eq__(self, other):
+    return _wrap_expr(self.c_expr.eq(_expr(other)))
+
+  def __ne__(self, other):
+    return _wrap_expr(self.c_expr.ne(_expr(other)))
+
+  def __lt__(self, other):
+    return _wrap_expr(self.c_expr.lt(_expr(other)))
+
+  def __le__(self, other):
+    return _wrap_expr(self.c_expr.le(_expr(other)))
+
+  def __gt__(self, other):
+    return _wrap_expr(self.c_expr.gt(_expr(other)))
+
+  def __ge__(self, other):
+    return _wrap_expr(self.c_expr.ge(_expr(other)))
+
+  # Python doesn't allow to overload 'and', 'or' and 'not', so bitwise
+  # operators are used for logical operations like in pandas.
+  def __and__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).logicalAnd(_expr(rhs)))
+
+  def __rand__(self, other):
+    return _wrap_expr(_expr(other).logicalAnd(self.c_expr))
+
+  def __or__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).logicalOr(_expr(rhs)))
+
+  def __ror__(self, other):
+    return _wrap_expr(_expr(other).logicalOr(self.c_expr))
+
+  def __invert__(self):
+    return _wrap_expr(self.c_expr.logicalNot())
+
+  def __add__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).add(_expr(rhs)))
+
+  def __radd__(self, other):
+    return _wrap_expr(_expr(other).add(self.c_expr))
+
+  def __sub__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).sub(_expr(rhs)))
+
+  def __rsub__(self, other):
+    return _wrap_expr(_expr(other).sub(self.c_expr))
+
+  def __mul__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).mul(_expr(rhs)))
+
+  def __rmul__(self, other):
+    return _wrap_expr(_expr(other).mul(self.c_expr))
+
+  def __truediv__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).div(_expr(rhs)))
+
+  def __rtruediv__(self, other):
+    return _wrap_expr(_expr(other).div(self.c_expr))
+
+  def __mod__(lhs, rhs):
+    return _wrap_expr(_expr(lhs).mod(_expr(rhs)))
+
+  def __rmod__(self, other):
+    return _wrap_expr(_expr(other).mod(self.c_expr))
+
+  def isNull(self):
+    return _wrap_expr(self.c_expr.isNull())
+
+  def isNotNull(self):
+    return _wrap_expr(self.c_expr.isNotNull())
+
+  def cast(self, TypeInfo type_info):
+    return _wrap_expr(self.c_expr.cast(type_info.c_type_info))
+
+  def count(self, bool distinct = False):
+    return _wrap_expr(self.c_expr.count(distinct))
+
+  def sum(self):
+    return _wrap_expr(self.c_expr.sum())
+
+  def avg(self):
+    return _wrap_expr(self.c_expr.avg())
+
+  def min(self):
+    return _wrap_expr(self.c_expr.min())
+
+  def max(self):
+    return _wrap_expr(self.c_expr.max())
+
+  def __repr__(self):
+    return f"BuilderExpr({self.name})"
+
+cdef class BuilderNode:
+  @property
+  def size(self):
+    return self.c_node.size()
+
+  @property
+  def fieldNames(self):
+    return self.c_node.fieldNames()
+
+  def ref(self, col):
+    if isinstance(col, BuilderExpr):
+      return col
+    if isinstance(col, str):
+      return _wrap_expr(self.c_node.refByName(col))
+    return _wrap_expr(self.c_node.ref(col))
+
+  def __getitem__(self, col):
+    return self.ref(col)
+
+  def proj(self, exprs):
+    cdef vector[CBuilderExpr] c_exprs
+    for expr in exprs:
+      c_exprs.push_back((<BuilderExpr>self.ref(expr)).c_expr)
+    return _wrap_node(self.c_node.proj(c_exprs))
+
+  def filter(self, condition):
+    return _wrap_node(self.c_node.filter(_expr(condition)))
+
+  def agg(self, group_keys, aggs):
+    cdef vector[CBuilderExpr] c_group_keys
+    cdef vector[CBuilderExpr] c_aggs
+    for key in group_keys:
+      c_group_keys.push_back((<BuilderExpr>self.ref(key)).c_expr)
+    for agg in aggs:
+      c_aggs.push_back(_expr(agg))
+    return _wrap_node(self.c_node.agg(c_group_keys, c_aggs))
+
+  def sort(self, fields, size_t limit = 0, size_t offset = 0):
+    """
+    Each sort field is a column or a tuple (column, "asc"|"desc"[, "first"|"last"])
+    where the last item specifies NULLs position. By default, NULLs go last
+    in ascending order and first in descending order, like in SQL.
+    """
+    cdef vector[CBuilderSortField] c_fields
+    cdef bool ascending
+    cdef bool nulls_first
+    for field in fields:
+      if not isinstance(field, tuple):
+        field = (field,)
+      if not 1 <= len(field) <= 3:
+        raise ValueError(f"Sort field should be a column or (column, direction[, nulls]), got {field}")
+      direction = field[1] if len(field) > 1 else "asc"
+      direction = direction.lower() if isinstance(direction, str) else direction
+      if direction not in ("asc", "desc"):
+        raise ValueError(f"Unsupported sort direction: {field[1]}. Expected 'asc' or 'desc'.")
+      ascending = direction == "asc"
+      nulls = field[2] if len(field) > 2 else ("last" if ascending else "first")
+      nulls = nulls.lower() if isinstance(nulls, str) else nulls
+      if nulls not in ("first", "last"):
+        raise ValueError(f"Unsupported NULLs position: {field[2]}. Expected 'first' or 'last'.")
+      nulls_first = nulls == "first"
+      c_fields.push_back(CBuilderSortField((<BuilderExpr>self.ref(field[0])).c_expr, ascending, nulls_first))
+    return _wrap_node(self.c_node.sort(c_fields, limit, offset))
+
+  def join(self, BuilderNode rhs, condition, how = "inner"):
+    cdef CJoinType join_type
+    if how == "inner":
+      join_type = CJoinType.INNER
+    elif how == "left":
+      join_type = CJoinType.LEFT
+    else:
+      raise ValueError(f"Unsupported join type: {how}")
+    return _wrap_node(self.c_node.join(rhs.c_node, _expr(condition), join_type))
+
+cdef class QueryBuilder:
+  def __cinit__(self, SchemaProvider schema_provider):
+    cdef int db_id = 0
+
+    db_ids = schema_provider.listDatabases()
+    assert len(db_ids) <= 1
+    if len(db_ids) == 1:
+      db_id = db_ids[0]
+
+    self.c_builder = make_unique[CQueryBuilder](schema_provider.c_schema_provider, db_id)
+
+  def scan(self, string table_name):
+    return _wrap_node(self.c_builder.get().scan(table_name))
+
+  def finalize(self, BuilderNode root):
+    cdef RelAlgDag res = RelAlgDag()
+    start = time.perf_counter()
+    res.c_dag = move(self.c_builder.get().finalize(root.c_node))
+    res.build_ms = (time.perf_counter() - start) * 1000
+    return res
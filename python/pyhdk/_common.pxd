@@ -3,6 +3,7 @@
 #
 # SPDX-License-Identifier: Apache-2.0
 
+from libc.stdint cimport int8_t, int16_t, int32_t, int64_t
 from libcpp cimport bool
 from libcpp.string cimport string
 
@@ -69,6 +70,15 @@ cdef extern from "omniscidb/Shared/sqltypes.h":
 
     string toString()
 
+  union CDatum "Datum":
+    int8_t boolval
+    int8_t tinyintval
+    int16_t smallintval
+    int32_t intval
+    int64_t bigintval
+    float floatval
+    double doubleval
+
 cdef class TypeInfo:
   cdef CSQLTypeInfo c_type_info
 
@@ -89,4 +99,12 @@ cdef extern from "omniscidb/Logger/Logger.h" namespace "logger":
   cdef cppclass CLogOptions "logger::LogOptions":
     CLogOptions(const char*)
 
+  enum CSeverity "logger::Severity":
+    INFO "logger::INFO",
+
+  cdef cppclass CDebugTimer "logger::DebugTimer":
+    CDebugTimer(CSeverity, const char*, int, const char*)
+
+    string stopAndGetJson()
+
   cdef void CInitLogger "logger::init"(const CLogOptions &)
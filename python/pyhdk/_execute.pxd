@@ -79,7 +79,8 @@ cdef extern from "omniscidb/QueryEngine/CompilationOptions.h":
 
 cdef extern from "omniscidb/QueryEngine/ResultSet.h":
   cdef cppclass CResultSet "ResultSet":
-    pass
+    size_t rowCount()
+    bool isZeroCopyColumnarConversionPossible(size_t)
 
 ctypedef shared_ptr[CResultSet] CResultSetPtr
 
@@ -93,7 +94,7 @@ cdef extern from "omniscidb/QueryEngine/ArrowResultSet.h":
   cdef cppclass CArrowResultSetConverter "ArrowResultSetConverter":
     CArrowResultSetConverter(const CResultSetPtr&, const vector[string]&, int)
 
-    shared_ptr[CArrowTable] convertToArrowTable()
+    shared_ptr[CArrowTable] convertToArrowTable() except + nogil
 
 cdef extern from "omniscidb/QueryEngine/Execute.h":
   cdef cppclass CExecutor "Executor":
@@ -55,6 +55,11 @@ cdef extern from "omniscidb/QueryEngine/RelAlgDagBuilder.h":
   cdef cppclass CRelAlgDagBuilder "RelAlgDagBuilder"(CRelAlgDag):
     CRelAlgDagBuilder(const string&, int, CSchemaProviderPtr) except +
 
+cdef class RelAlgDag:
+  cdef unique_ptr[CRelAlgDag] c_dag
+  # Time spent to build the DAG in milliseconds, None if not measured.
+  cdef readonly object build_ms
+
 cdef extern from "omniscidb/QueryEngine/Descriptors/RelAlgExecutionDescriptor.h":
   cdef cppclass CExecutionResult "ExecutionResult":
     CExecutionResult()
@@ -69,4 +74,4 @@ cdef extern from "omniscidb/QueryEngine/RelAlgExecutor.h":
   cdef cppclass CRelAlgExecutor "RelAlgExecutor":
     CRelAlgExecutor(CExecutor*, CSchemaProviderPtr, CDataProvider*, unique_ptr[CRelAlgDag])
 
-    CExecutionResult executeRelAlgQuery(const CCompilationOptions&, const CExecutionOptions&, const bool) except +
+    CExecutionResult executeRelAlgQuery(const CCompilationOptions&, const CExecutionOptions&, const bool) except + nogil
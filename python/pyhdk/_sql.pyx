@@ -7,6 +7,14 @@ from libcpp.memory cimport make_shared, make_unique
 from libcpp.utility cimport move
 from cython.operator cimport dereference, preincrement
 
+import json
+import pyarrow
+import re
+import resource
+import threading
+import time
+from collections import OrderedDict
+
 from pyarrow.lib cimport pyarrow_wrap_table
 from pyarrow.lib cimport CTable as CArrowTable
 
@@ -14,8 +22,11 @@ from pyhdk._common cimport g_enable_columnar_output
 from pyhdk._common cimport g_enable_watchdog
 from pyhdk._common cimport g_enable_dynamic_watchdog
 from pyhdk._common cimport g_enable_lazy_fetch
-from pyhdk._storage cimport SchemaProvider, CDataMgr, DataMgr
-from pyhdk._execute cimport Executor, CExecutorDeviceType, CArrowResultSetConverter
+from pyhdk._common cimport g_enable_debug_timer
+from pyhdk._common cimport CDebugTimer, CSeverity
+from pyhdk._storage cimport SchemaProvider, Storage, CDataMgr, DataMgr
+from pyhdk._storage cimport MemoryLevel, MemStatus
+from pyhdk._execute cimport Executor, CExecutorDeviceType, CArrowResultSetConverter, CResultSet
 
 cdef class Calcite:
   cdef shared_ptr[CalciteJNI] calcite
@@ -44,6 +55,37 @@ cdef class Calcite:
     cdef bool is_view_optimize = kwargs.get("is_view_optimize", False)
     return self.calcite.get().process(user, db_name, sql, filter_push_down_info, legacy_syntax, is_explain, is_view_optimize)
 
+def _elapsed_ms(start):
+  return (time.perf_counter() - start) * 1000
+
+def _peak_rss_mb():
+  # ru_maxrss is in kilobytes on Linux.
+  return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024
+
+def _bind_buffers_lifetime(table, owner, zero_copy_columns):
+  # Columns listed in zero_copy_columns are exported without copying and
+  # their Arrow buffers point to ResultSet memory. Re-wrap such buffers to make
+  # them hold a reference to the owning ExecutionResult.
+  if not zero_copy_columns:
+    return table
+
+  columns = []
+  for col_idx, column in enumerate(table.columns):
+    if col_idx not in zero_copy_columns:
+      columns.append(column)
+      continue
+
+    col_type = column.type
+    chunks = []
+    for chunk in column.chunks:
+      buffers = [
+        None if buf is None else pyarrow.foreign_buffer(buf.address, buf.size, base=(owner, buf))
+        for buf in chunk.buffers()
+      ]
+      chunks.append(pyarrow.Array.from_buffers(col_type, len(chunk), buffers, chunk.null_count, chunk.offset))
+    columns.append(pyarrow.chunked_array(chunks, col_type))
+  return pyarrow.Table.from_arrays(columns, schema=table.schema)
+
 cdef class ExecutionResult:
   cdef CExecutionResult c_result
   # DataMgr has to outlive ResultSet objects to avoid use-after-free errors.
@@ -51,6 +93,11 @@ cdef class ExecutionResult:
   # obects lifetime control. In Python we achieve it by holding DataMgr in
   # each ExecutionResult object.
   cdef shared_ptr[CDataMgr] c_data_mgr
+  # Per-query profile: timings of measured phases in milliseconds, result
+  # size, bytes fetched into each memory level for queries executed with
+  # profile=True and, with globally enabled debug timers, the engine timers
+  # tree.
+  cdef readonly dict profile
 
   def to_arrow(self):
     cdef vector[string] col_names
@@ -60,34 +107,91 @@ cdef class ExecutionResult:
       col_names.push_back(dereference(it).get_resname())
       preincrement(it)
 
+    cdef CResultSet* rows = self.c_result.getRows().get()
+    zero_copy_columns = set()
+    for col_idx in range(col_names.size()):
+      if rows.isZeroCopyColumnarConversionPossible(col_idx):
+        zero_copy_columns.add(col_idx)
+
     cdef unique_ptr[CArrowResultSetConverter] converter = make_unique[CArrowResultSetConverter](self.c_result.getRows(), col_names, -1)
-    cdef shared_ptr[CArrowTable] at = converter.get().convertToArrowTable()
-    return pyarrow_wrap_table(at)
+    cdef shared_ptr[CArrowTable] at
+    start = time.perf_counter()
+    with nogil:
+      at = converter.get().convertToArrowTable()
+    res = _bind_buffers_lifetime(pyarrow_wrap_table(at), self, zero_copy_columns)
+    if self.profile is not None:
+      conversion_ms = _elapsed_ms(start)
+      self.profile["arrow_conversion_ms"] = conversion_ms
+      self.profile["arrow_bytes"] = res.nbytes
+      if conversion_ms > 0:
+        self.profile["arrow_export_mb_per_s"] = res.nbytes / 1e6 / (conversion_ms / 1000)
+      self.profile["peak_rss_mb"] = _peak_rss_mb()
+    return res
 
   def to_explain_str(self):
     return self.c_result.getExplanation()
 
+cdef class RelAlgDag:
+  pass
+
+cdef size_t _used_bytes(CDataMgr* data_mgr, MemoryLevel level) except *:
+  cdef size_t res = 0
+  for info in data_mgr.getMemoryInfo(level):
+    for node in info.nodeMemoryData:
+      if node.memStatus == MemStatus.USED:
+        res += node.numPages * info.pageSize
+  return res
+
+cdef dict _used_bytes_by_level(CDataMgr* data_mgr):
+  return {
+    "cpu": _used_bytes(data_mgr, MemoryLevel.CPU_LEVEL),
+    "gpu": _used_bytes(data_mgr, MemoryLevel.GPU_LEVEL),
+  }
+
 cdef class RelAlgExecutor:
   cdef shared_ptr[CRelAlgExecutor] c_rel_alg_executor
   # DataMgr is used only to pass it to each produced ExecutionResult
   cdef shared_ptr[CDataMgr] c_data_mgr
+  # Planning phases timings copied to each produced ExecutionResult profile.
+  cdef readonly dict profile
+  # RelAlgExecutor keeps per-query state, so executions of the same query
+  # are serialized. Different queries run concurrently with released GIL.
+  cdef object lock
 
-  def __cinit__(self, Executor executor, SchemaProvider schema_provider, DataMgr data_mgr, string ra_json):
+  def __cinit__(self, Executor executor, SchemaProvider schema_provider, DataMgr data_mgr, ra):
+    start = time.perf_counter()
     cdef CExecutor* c_executor = executor.c_executor.get()
     cdef CSchemaProviderPtr c_schema_provider = schema_provider.c_schema_provider
     cdef CDataProvider* c_data_provider = data_mgr.c_data_mgr.get().getDataProvider()
     cdef unique_ptr[CRelAlgDag] c_dag
+    cdef string ra_json
     cdef int db_id = 0
 
-    db_ids = schema_provider.listDatabases()
-    assert len(db_ids) <= 1
-    if len(db_ids) == 1:
-      db_id = db_ids[0]
+    # Query can be passed as RA JSON produced by Calcite or as a DAG built with
+    # QueryBuilder. Built DAG is owned by the executor after this call.
+    if isinstance(ra, RelAlgDag):
+      if (<RelAlgDag>ra).c_dag.get() == NULL:
+        raise ValueError("RelAlgDag was already passed to another RelAlgExecutor")
+      c_dag = move((<RelAlgDag>ra).c_dag)
+      dag_build_ms = (<RelAlgDag>ra).build_ms
+    else:
+      ra_json = ra
+      db_ids = schema_provider.listDatabases()
+      assert len(db_ids) <= 1
+      if len(db_ids) == 1:
+        db_id = db_ids[0]
 
-    c_dag.reset(new CRelAlgDagBuilder(ra_json, db_id, c_schema_provider))
+      c_dag.reset(new CRelAlgDagBuilder(ra_json, db_id, c_schema_provider))
+      dag_build_ms = _elapsed_ms(start)
 
     self.c_rel_alg_executor = make_shared[CRelAlgExecutor](c_executor, c_schema_provider, c_data_provider, move(c_dag))
     self.c_data_mgr = data_mgr.c_data_mgr
+    # Only measured phases are reported. Calcite time is added by the caller
+    # which ran Calcite, e.g. QueryCache. Built DAGs are timed in finalize.
+    self.profile = {}
+    if dag_build_ms is not None:
+      self.profile["dag_build_ms"] = dag_build_ms
+    self.lock = threading.Lock()
 
   def execute(self, **kwargs):
     global g_enable_columnar_output
@@ -102,8 +206,352 @@ cdef class RelAlgExecutor:
     c_eo.with_watchdog = kwargs.get("enable_watchdog", g_enable_watchdog)
     c_eo.with_dynamic_watchdog = kwargs.get("enable_dynamic_watchdog", g_enable_dynamic_watchdog)
     c_eo.just_explain = kwargs.get("just_explain", False)
-    cdef CExecutionResult c_res = self.c_rel_alg_executor.get().executeRelAlgQuery(c_co, c_eo, False)
+
+    # With profile=True, measure growth of the buffer pools, i.e. bytes of
+    # chunks fetched into each memory level by the query. With globally
+    # enabled debug timers, collect engine timers (code generation, data
+    # fetch, kernels execution, reduction) under a root timer and return them
+    # in the profile instead of writing them to the log.
+    profile = kwargs.get("profile", False)
+    cdef CDebugTimer* timer = NULL
+    cdef CExecutionResult c_res
+    cdef CRelAlgExecutor* c_rel_alg_executor = self.c_rel_alg_executor.get()
+    with self.lock:
+      used_before = _used_bytes_by_level(self.c_data_mgr.get()) if profile else None
+      if g_enable_debug_timer:
+        timer = new CDebugTimer(CSeverity.INFO, b"_sql.pyx", 0, b"RelAlgExecutor.execute")
+      try:
+        start = time.perf_counter()
+        with nogil:
+          c_res = c_rel_alg_executor.executeRelAlgQuery(c_co, c_eo, False)
+        execution_ms = _elapsed_ms(start)
+        timers = timer.stopAndGetJson() if timer != NULL else ""
+      finally:
+        del timer
+      used_after = _used_bytes_by_level(self.c_data_mgr.get()) if profile else None
+
     cdef ExecutionResult res = ExecutionResult()
     res.c_result = move(c_res)
     res.c_data_mgr = self.c_data_mgr
+    res.profile = dict(self.profile)
+    res.profile["execution_ms"] = execution_ms
+    if res.c_result.getRows().get() != NULL:
+      res.profile["result_rows"] = res.c_result.getRows().get().rowCount()
+    if profile:
+      res.profile["fetched_bytes"] = {
+        level: max(used_after[level] - used_before[level], 0) for level in used_after
+      }
+    if timers:
+      res.profile["timers"] = json.loads(timers)
     return res
+
+def _collapse_whitespace(sql):
+  # Collapse whitespaces outside of quoted literals.
+  parts = re.split(r"('(?:[^']|'')*')", sql)
+  parts[::2] = [re.sub(r"\s+", " ", part) for part in parts[::2]]
+  return "".join(parts)
+
+def _normalize_sql(sql):
+  # Drop the trailing semicolon and collapse whitespaces so that formatting
+  # differences don't produce cache misses.
+  return _collapse_whitespace(sql).strip().rstrip(";").rstrip()
+
+# String literals, quoted identifiers and unsigned integer literals.
+_SQL_LITERAL_RE = re.compile(r"""('(?:[^']|'')*')|("(?:[^"]|"")*")|(?<![\w.$])(\d+)(?![\w.])""")
+# Typed literals like DATE '2000-01-01' are parsed by Calcite and are kept
+# in the query template.
+_TYPED_LITERAL_PREFIX_RE = re.compile(r"\b(?:DATE|TIME|TIMESTAMP|INTERVAL)\s*$", re.IGNORECASE)
+_INT32_MAX = 2**31 - 1
+_INT64_MAX = 2**63 - 1
+
+def _split_literals(sql):
+  """
+  Split SQL into text parts and literal parameters between them. Integer
+  and string literals are extracted, other literals stay in the text.
+  """
+  parts = []
+  params = []
+  pos = 0
+  for m in _SQL_LITERAL_RE.finditer(sql):
+    if m.group(2) is not None:
+      continue
+    if m.group(1) is not None:
+      if _TYPED_LITERAL_PREFIX_RE.search(sql, 0, m.start()):
+        continue
+      value = m.group(1)[1:-1].replace("''", "'")
+    else:
+      value = int(m.group(3))
+      if value > _INT64_MAX:
+        continue
+    parts.append(sql[pos:m.start()])
+    params.append(value)
+    pos = m.end()
+  parts.append(sql[pos:])
+  return parts, params
+
+def _param_class(value):
+  if isinstance(value, str):
+    return "s"
+  return "i" if value <= _INT32_MAX else "l"
+
+def _template_key(parts, params, options):
+  norm_parts = [_collapse_whitespace(part) for part in parts]
+  norm_parts[0] = norm_parts[0].lstrip()
+  norm_parts[-1] = norm_parts[-1].rstrip().rstrip(";").rstrip()
+  return (tuple(norm_parts), tuple(_param_class(value) for value in params), options)
+
+def _sentinel(idx, value):
+  # Values are chosen to differ from the original literal, including its
+  # length, so that any dependency of the plan on the literal value is
+  # detected when the plans are compared.
+  if isinstance(value, str):
+    res = f"hdk_param_{idx}_"
+    return res if len(res) != len(value) else res + "_"
+  base = 2_000_000_000 if value <= _INT32_MAX else 9_000_000_000_000_000_000
+  res = base + idx
+  return res if res != value else res + 1_000_000
+
+def _literal_nodes(node, path, res):
+  if isinstance(node, dict):
+    if "literal" in node:
+      res.append((path, node))
+      return
+    for key, val in node.items():
+      _literal_nodes(val, path + (key,), res)
+  elif isinstance(node, list):
+    for idx, val in enumerate(node):
+      _literal_nodes(val, path + (idx,), res)
+
+def _get_path(node, path):
+  for key in path:
+    node = node[key]
+  return node
+
+def _value_fields(value):
+  # Literal node fields which depend on the literal value. Precision of
+  # string literals is their length, for integers it's the number of digits.
+  if isinstance(value, str):
+    return ("literal", "precision", "type_precision")
+  return ("literal", "precision")
+
+def _strip_literals(node, params, param_paths):
+  # Return a copy of the plan with value-dependent fields of parameter
+  # literals removed.
+  res = json.loads(json.dumps(node))
+  for value, paths in zip(params, param_paths):
+    for path in paths:
+      lit = _get_path(res, path)
+      for field in _value_fields(value):
+        lit.pop(field, None)
+  return res
+
+def _same_value(lit_value, value):
+  # Avoid matching booleans with integers.
+  return type(lit_value) is type(value) and lit_value == value
+
+class _PlanTemplate:
+  """
+  RA JSON of a query with literal parameters replaced with placeholders.
+  Binding parameters produces the same plan Calcite would produce for the
+  query with these literals.
+  """
+
+  def __init__(self, ra, param_paths):
+    self.ra = ra
+    self.param_paths = param_paths
+
+  @staticmethod
+  def create(process, parts, params, ra):
+    """
+    Build a template from the plan produced for the original query. The
+    query is planned once more with sentinel literals to locate parameters
+    in the plan. Returns None if the plan depends on literal values other
+    than through literal nodes, e.g. when Calcite folds constants.
+    """
+    sentinels = [_sentinel(idx, value) for idx, value in enumerate(params)]
+    sentinel_sql = parts[0]
+    for sentinel, part in zip(sentinels, parts[1:]):
+      if isinstance(sentinel, str):
+        sentinel_sql += f"'{sentinel}'"
+      else:
+        sentinel_sql += str(sentinel)
+      sentinel_sql += part
+    try:
+      sentinel_ra = json.loads(process(sentinel_sql))
+    except Exception:
+      return None
+    actual_ra = json.loads(ra)
+
+    literals = []
+    _literal_nodes(sentinel_ra, (), literals)
+    param_paths = [[] for _ in params]
+    for path, lit in literals:
+      for idx, sentinel in enumerate(sentinels):
+        if _same_value(lit["literal"], sentinel):
+          param_paths[idx].append(path)
+    if not all(param_paths):
+      return None
+
+    # Parameters should be found at the same places in the original plan
+    # and the rest of plans should match.
+    try:
+      for value, paths in zip(params, param_paths):
+        for path in paths:
+          if not _same_value(_get_path(actual_ra, path)["literal"], value):
+            return None
+      if _strip_literals(actual_ra, params, param_paths) != _strip_literals(sentinel_ra, params, param_paths):
+        return None
+    except (KeyError, IndexError, TypeError):
+      return None
+
+    return _PlanTemplate(actual_ra, param_paths)
+
+  def bind(self, params):
+    ra = json.loads(json.dumps(self.ra))
+    for value, paths in zip(params, self.param_paths):
+      for path in paths:
+        lit = _get_path(ra, path)
+        lit["literal"] = value
+        if isinstance(value, str):
+          lit["precision"] = len(value)
+          lit["type_precision"] = len(value)
+        else:
+          lit["precision"] = len(str(value))
+    return json.dumps(ra)
+
+def _execute_cached(RelAlgExecutor rel_alg_executor, cache_hit, kwargs):
+  res = rel_alg_executor.execute(**kwargs)
+  res.profile["plan_cache_hit"] = cache_hit
+  if cache_hit:
+    # Planning phases were skipped for this query.
+    res.profile.pop("calcite_ms", None)
+    res.profile.pop("plan_bind_ms", None)
+    res.profile.pop("plan_template_ms", None)
+    res.profile.pop("dag_build_ms", None)
+  return res
+
+# Marks template keys seen once. A template is verified only when its key is
+# seen again, so query shapes which are run once don't pay for the extra
+# Calcite call.
+_TEMPLATE_SEEN_ONCE = object()
+
+cdef class QueryCache:
+  """
+  Cache of parsed query plans keyed by the normalized SQL text, Calcite
+  options and the storage schema version.
+
+  A cache hit skips Calcite parsing and RelAlgDag build and re-executes the
+  cached RelAlgExecutor.
+
+  Queries are also matched by their template, i.e. the query text with
+  integer and string literals replaced with placeholders. For a new query
+  with a known template, the cached plan is re-bound to the query literals
+  and only the RelAlgDag is built, Calcite is not called. A template is
+  created when a query shape is planned for the second time. It is verified
+  by planning the query once more with different literals. If the plan
+  depends on literal values in other ways (e.g. Calcite folds constants),
+  the template is not used.
+
+  All entries are dropped when the storage schema changes. The cache can be
+  used from multiple threads, planning is serialized.
+  """
+  cdef Calcite calcite
+  cdef Executor executor
+  cdef Storage storage
+  cdef DataMgr data_mgr
+  cdef object entries
+  cdef object templates
+  cdef size_t max_size
+  cdef size_t schema_version
+  cdef object lock
+  cdef readonly size_t hits
+  cdef readonly size_t misses
+  cdef readonly size_t template_hits
+
+  def __cinit__(self, Calcite calcite, Executor executor, Storage storage, DataMgr data_mgr, size_t max_size = 256):
+    self.calcite = calcite
+    self.executor = executor
+    self.storage = storage
+    self.data_mgr = data_mgr
+    self.entries = OrderedDict()
+    self.templates = OrderedDict()
+    self.max_size = max_size
+    self.schema_version = storage.schema_version
+    self.lock = threading.Lock()
+
+  def prepare(self, sql, **kwargs):
+    return self._prepare(sql, kwargs)[0]
+
+  cdef tuple _prepare(self, sql, dict kwargs):
+    # Return the executor for the query and whether it was a cache hit.
+    with self.lock:
+      if self.schema_version != self.storage.schema_version:
+        self._clear()
+        self.schema_version = self.storage.schema_version
+
+      # Calcite options change the produced plan, so they are part of the key.
+      options = tuple(sorted(kwargs.items()))
+      key = (_normalize_sql(sql), options)
+      rel_alg_executor = self.entries.get(key)
+      if rel_alg_executor is not None:
+        self.hits += 1
+        self.entries.move_to_end(key)
+        return rel_alg_executor, True
+
+      self.misses += 1
+      rel_alg_executor = self._plan(sql, kwargs, options)
+      self.entries[key] = rel_alg_executor
+      if len(self.entries) > self.max_size:
+        self.entries.popitem(last=False)
+      return rel_alg_executor, False
+
+  cdef RelAlgExecutor _plan(self, sql, dict kwargs, tuple options):
+    parts, params = _split_literals(sql)
+    template_key = _template_key(parts, params, options)
+    # None marks templates which cannot be re-bound.
+    template = self.templates.get(template_key, False)
+    template_hit = isinstance(template, _PlanTemplate)
+    template_ms = None
+    start = time.perf_counter()
+    if template_hit:
+      self.template_hits += 1
+      self.templates.move_to_end(template_key)
+      ra = template.bind(params)
+      bind_ms = _elapsed_ms(start)
+    else:
+      ra = self.calcite.process(sql, **kwargs)
+      calcite_ms = _elapsed_ms(start)
+      if params and template is _TEMPLATE_SEEN_ONCE:
+        start = time.perf_counter()
+        template = _PlanTemplate.create(lambda text: self.calcite.process(text, **kwargs), parts, params, ra)
+        template_ms = _elapsed_ms(start)
+        self.templates[template_key] = template
+      elif params and template is False:
+        self.templates[template_key] = _TEMPLATE_SEEN_ONCE
+      if len(self.templates) > self.max_size:
+        self.templates.popitem(last=False)
+
+    cdef RelAlgExecutor rel_alg_executor = RelAlgExecutor(self.executor, self.storage, self.data_mgr, ra)
+    if template_hit:
+      rel_alg_executor.profile["plan_bind_ms"] = bind_ms
+    else:
+      rel_alg_executor.profile["calcite_ms"] = calcite_ms
+    if template_ms is not None:
+      rel_alg_executor.profile["plan_template_ms"] = template_ms
+    rel_alg_executor.profile["plan_template_hit"] = template_hit
+    return rel_alg_executor
+
+  def execute(self, sql, **kwargs):
+    rel_alg_executor, cache_hit = self._prepare(sql, {})
+    return _execute_cached(rel_alg_executor, cache_hit, kwargs)
+
+  def clear(self):
+    with self.lock:
+      self._clear()
+
+  cdef _clear(self):
+    self.entries.clear()
+    self.templates.clear()
+
+  def __len__(self):
+    return len(self.entries)
@@ -11,7 +11,7 @@ from libcpp.map cimport map
 
 from pyarrow.lib cimport CTable as CArrowTable
 
-from pyhdk._common cimport CSQLTypeInfo, CSystemParameters
+from pyhdk._common cimport CSQLTypeInfo, CSystemParameters, CDatum
 
 cdef extern from "omniscidb/DataMgr/MemoryLevel.h" namespace "Data_Namespace":
   enum MemoryLevel:
@@ -92,9 +92,32 @@ cdef extern from "omniscidb/DataMgr/AbstractBufferMgr.h" namespace "Data_Namespa
   cdef cppclass CAbstractBufferMgr "AbstractBufferMgr":
     pass
 
+cdef extern from "omniscidb/DataMgr/ChunkMetadata.h":
+  cdef cppclass CChunkStats "ChunkStats":
+    CDatum min
+    CDatum max
+    bool has_nulls
+
+  cdef cppclass CChunkMetadata "ChunkMetadata":
+    CSQLTypeInfo sqlType
+    size_t numBytes
+    size_t numElements
+    CChunkStats chunkStats
+
+ctypedef map[int, shared_ptr[CChunkMetadata]] CChunkMetadataMap
+
 cdef extern from "omniscidb/DataMgr/AbstractDataProvider.h":
+  cdef cppclass CFragmentInfo "FragmentInfo":
+    int fragmentId
+
+    size_t getPhysicalNumTuples()
+    const CChunkMetadataMap& getChunkMetadataMap()
+
+  cdef cppclass CTableFragmentsInfo "TableFragmentsInfo":
+    vector[CFragmentInfo] fragments
+
   cdef cppclass CAbstractDataProvider "AbstractDataProvider"(CAbstractBufferMgr):
-    pass
+    CTableFragmentsInfo getTableMetadata(int, int) except +
 
 cdef extern from "omniscidb/ArrowStorage/ArrowStorage.h" namespace "ArrowStorage":
   struct CColumnDescription "ArrowStorage::ColumnDescription":
@@ -103,6 +126,7 @@ cdef extern from "omniscidb/ArrowStorage/ArrowStorage.h" namespace "ArrowStorage
 
   struct CTableOptions "ArrowStorage::TableOptions":
     size_t fragment_size;
+    bool is_stream;
 
   struct CCsvParseOptions "ArrowStorage::CsvParseOptions":
     char delimiter;
@@ -116,13 +140,19 @@ cdef extern from "omniscidb/ArrowStorage/ArrowStorage.h" namespace "ArrowStorage
 
 cdef class Storage(SchemaProvider):
   cdef shared_ptr[CAbstractBufferMgr] c_abstract_buffer_mgr
+  # Incremented on each schema change. Used to invalidate cached query plans.
+  cdef readonly size_t schema_version
 
 cdef extern from "omniscidb/ArrowStorage/ArrowStorage.h":
   cdef cppclass CArrowStorage "ArrowStorage"(CSchemaProvider, CAbstractDataProvider):
     CArrowStorage(int, string, int);
 
-    CTableInfoPtr importArrowTable(shared_ptr[CArrowTable], string&, CTableOptions&);
-    void dropTable(const string&, bool)
+    CTableInfoPtr importArrowTable(shared_ptr[CArrowTable], string&, CTableOptions&) except +
+    void appendArrowTable(shared_ptr[CArrowTable], const string&) except + nogil
+    CTableInfoPtr importCsvFile(const string&, const string&, const CTableOptions&, const CCsvParseOptions) except + nogil
+    void appendCsvFile(const string&, const string&, const CCsvParseOptions) except + nogil
+    CTableInfoPtr importJsonFile(const string&, const string&, const CTableOptions&, const CJsonParseOptions) except + nogil
+    void dropTable(const string&, bool) except +
 
 cdef extern from "omniscidb/BufferProvider/BufferProvider.h" namespace "Data_Namespace":
   cdef cppclass CBufferProvider "BufferProvider":
@@ -144,10 +174,25 @@ cdef extern from "omniscidb/DataMgr/PersistentStorageMgr/PersistentStorageMgr.h"
   cdef cppclass CPersistentStorageMgr "PersistentStorageMgr"(CAbstractBufferMgr):
     void registerDataProvider(int, shared_ptr[CAbstractBufferMgr]);
 
+cdef extern from "omniscidb/DataMgr/BufferMgr/BufferSeg.h" namespace "Buffer_Namespace":
+  enum MemStatus:
+    FREE,
+    USED,
+
 cdef extern from "omniscidb/DataMgr/DataMgr.h" namespace "Data_Namespace":
+  struct CMemoryData "Data_Namespace::MemoryData":
+    size_t numPages
+    MemStatus memStatus
+
+  struct CMemoryInfo "Data_Namespace::MemoryInfo":
+    size_t pageSize
+    vector[CMemoryData] nodeMemoryData
+
   cdef cppclass CDataMgr "DataMgr":
     CDataMgr(const string&, const CSystemParameters&, map[CGpuMgrName, unique_ptr[CGpuMgr]]&& gpuMgrs, size_t reservedGpuMem, size_t numReaderThreads)
 
+    vector[CMemoryInfo] getMemoryInfo(const MemoryLevel) except +
+
     CPersistentStorageMgr* getPersistentStorageMgr()
     CBufferProvider* getBufferProvider()
     CDataProvider* getDataProvider()
@@ -13,7 +13,48 @@ from cython.operator cimport dereference, preincrement
 from pyarrow.lib cimport pyarrow_unwrap_table
 from pyarrow.lib cimport CTable as CArrowTable
 
-from pyhdk._common cimport TypeInfo
+import decimal
+import pyarrow
+import pyarrow.dataset
+
+from pyhdk._common cimport TypeInfo, CDatum, CSQLTypeInfo, CSQLTypes
+from pyhdk._common cimport kBOOLEAN, kTINYINT, kSMALLINT, kINT, kBIGINT, kFLOAT, kDOUBLE
+from pyhdk._common cimport kDECIMAL, kNUMERIC, kTIME, kTIMESTAMP, kDATE
+
+cdef _datum_to_py(const CDatum& datum, const CSQLTypeInfo& type_info):
+  cdef CSQLTypes type = type_info.get_type()
+  if type == kBOOLEAN:
+    return datum.boolval != 0
+  if type == kTINYINT:
+    return datum.tinyintval
+  if type == kSMALLINT:
+    return datum.smallintval
+  if type == kINT:
+    return datum.intval
+  if type == kBIGINT:
+    return datum.bigintval
+  if type == kFLOAT:
+    return datum.floatval
+  if type == kDOUBLE:
+    return datum.doubleval
+  if type == kDECIMAL or type == kNUMERIC:
+    return decimal.Decimal(datum.bigintval).scaleb(-type_info.get_scale())
+  # Temporal values are returned in their storage units.
+  if type == kTIME or type == kTIMESTAMP or type == kDATE:
+    return datum.bigintval
+  # Min/max of dictionary encoded strings are dictionary ids, which are
+  # meaningless for users.
+  return None
+
+def _distinct_upper_bound(min_val, max_val, num_elements):
+  # Chunk stats hold no distinct counts, but for integer, boolean and temporal
+  # values the value range bounds the number of distinct values. Python
+  # booleans are integers too.
+  if min_val is None or max_val is None:
+    return None
+  if isinstance(min_val, int):
+    return min(num_elements, max_val - min_val + 1)
+  return None
 
 cdef class TableInfo:
   @property
@@ -170,8 +211,31 @@ cdef class SchemaProvider:
 cdef class TableOptions:
   cdef CTableOptions c_options
 
-  def __cinit__(self, int fragment_size):
+  def __cinit__(self, int fragment_size, bool is_stream = False):
     self.c_options.fragment_size = fragment_size
+    self.c_options.is_stream = is_stream
+
+cdef class CsvParseOptions:
+  cdef CCsvParseOptions c_options
+
+  def __cinit__(self, *, delimiter=None, header=None, skip_rows=None, block_size=None):
+    if delimiter is not None:
+      self.c_options.delimiter = ord(delimiter)
+    if header is not None:
+      self.c_options.header = header
+    if skip_rows is not None:
+      self.c_options.skip_rows = skip_rows
+    if block_size is not None:
+      self.c_options.block_size = block_size
+
+cdef class JsonParseOptions:
+  cdef CJsonParseOptions c_options
+
+  def __cinit__(self, *, skip_rows=None, block_size=None):
+    if skip_rows is not None:
+      self.c_options.skip_rows = skip_rows
+    if block_size is not None:
+      self.c_options.block_size = block_size
 
 cdef class ArrowStorage(Storage):
   cdef shared_ptr[CArrowStorage] c_storage
@@ -186,9 +250,137 @@ cdef class ArrowStorage(Storage):
   def importArrowTable(self, table, name, TableOptions options):
     cdef shared_ptr[CArrowTable] at = pyarrow_unwrap_table(table)
     self.c_storage.get().importArrowTable(at, name, options.c_options)
+    self.schema_version += 1
+
+  def createTable(self, name, schema, TableOptions options):
+    """
+    Create an empty stream table with the specified Arrow schema. Data can
+    be added to it later through appendArrowTable.
+    """
+    stream_options = TableOptions(options.c_options.fragment_size, True)
+    self.importArrowTable(schema.empty_table(), name, stream_options)
+
+  def appendArrowTable(self, data, string name):
+    """
+    Append data to an existing table. Accepts pyarrow.Table, RecordBatch,
+    a list of RecordBatches, or RecordBatchReader. New rows fill the last
+    table fragment first and then go to new fragments of the table's
+    fragment size. Each call is applied atomically: concurrent queries see
+    the table either before or after it. Batches of a RecordBatchReader are
+    appended one by one.
+    """
+    if isinstance(data, pyarrow.RecordBatchReader):
+      for batch in data:
+        self._appendArrowTable(pyarrow.Table.from_batches([batch]), name)
+      return
+
+    if isinstance(data, pyarrow.RecordBatch):
+      data = pyarrow.Table.from_batches([data])
+    elif isinstance(data, list):
+      data = pyarrow.Table.from_batches(data)
+    self._appendArrowTable(data, name)
+
+  def _appendArrowTable(self, table, string name):
+    cdef shared_ptr[CArrowTable] at = pyarrow_unwrap_table(table)
+    with nogil:
+      self.c_storage.get().appendArrowTable(at, name)
+
+  def importCsvFile(self, string file_name, string table_name, TableOptions options, CsvParseOptions parse_options = None):
+    """
+    Import CSV file into a new table. The file is parsed by blocks in
+    multiple threads.
+    """
+    if parse_options is None:
+      parse_options = CsvParseOptions()
+    with nogil:
+      self.c_storage.get().importCsvFile(file_name, table_name, options.c_options, parse_options.c_options)
+    self.schema_version += 1
+
+  def appendCsvFile(self, string file_name, string table_name, CsvParseOptions parse_options = None):
+    if parse_options is None:
+      parse_options = CsvParseOptions()
+    with nogil:
+      self.c_storage.get().appendCsvFile(file_name, table_name, parse_options.c_options)
+
+  def importJsonFile(self, string file_name, string table_name, TableOptions options, JsonParseOptions parse_options = None):
+    """
+    Import line-delimited JSON file into a new table. The file is parsed
+    by blocks in multiple threads.
+    """
+    if parse_options is None:
+      parse_options = JsonParseOptions()
+    with nogil:
+      self.c_storage.get().importJsonFile(file_name, table_name, options.c_options, parse_options.c_options)
+    self.schema_version += 1
+
+  def importParquetFile(self, file_name, table_name, TableOptions options, columns=None, filter=None):
+    """
+    Import Parquet file into a new table. Only the specified columns are read.
+    The optional filter is a pyarrow.dataset.Expression. Row groups that
+    cannot match the filter are skipped using their statistics. Data is read
+    in multiple threads and appended to the table in a single call, both
+    without holding the GIL.
+    """
+    dataset = pyarrow.dataset.dataset(file_name, format="parquet")
+    scanner = dataset.scanner(columns=columns, filter=filter, use_threads=True)
+    self.importArrowTable(scanner.projected_schema.empty_table(), table_name, options)
+    try:
+      self._appendArrowTable(scanner.to_table(), table_name)
+    except BaseException:
+      # Don't leave a partially loaded table.
+      self.dropTable(table_name)
+      raise
 
   def dropTable(self, string name, bool throw_if_not_exist = False):
     self.c_storage.get().dropTable(name, throw_if_not_exist)
+    self.schema_version += 1
+
+  def getFragmentStats(self, table):
+    """
+    Return statistics of table fragments computed on import and append.
+    Executor uses them to skip fragments which cannot match filter
+    conditions. For each fragment, a dictionary with the fragment id, its
+    row count and per-column stats (min, max, has_nulls, num_bytes) is
+    returned. Min and max are None for strings, decimals are returned as
+    decimal.Decimal. For integer, boolean and temporal columns,
+    distinct_upper_bound is the maximum number of distinct values allowed by
+    the value range and the number of values, for other columns it is None.
+    """
+    cdef int db_id = self.listDatabases()[0]
+    cdef TableInfo table_info = self.getTableInfo(db_id, table)
+    if table_info.c_table_info.get() == NULL:
+      raise ValueError(f"Unknown table: {table}")
+    column_names = {col.column_id: col.name for col in self.listColumns(db_id, table_info.table_id)}
+    cdef CTableFragmentsInfo c_table_meta = self.c_storage.get().getTableMetadata(db_id, table_info.table_id)
+
+    res = []
+    cdef vector[CFragmentInfo].iterator frag_it = c_table_meta.fragments.begin()
+    cdef CChunkMetadataMap.const_iterator chunk_it
+    cdef CChunkMetadata* c_chunk_meta
+    while frag_it != c_table_meta.fragments.end():
+      columns = {}
+      chunk_it = dereference(frag_it).getChunkMetadataMap().const_begin()
+      while chunk_it != dereference(frag_it).getChunkMetadataMap().const_end():
+        c_chunk_meta = dereference(chunk_it).second.get()
+        name = column_names.get(dereference(chunk_it).first)
+        if name is not None:
+          min_val = _datum_to_py(c_chunk_meta.chunkStats.min, c_chunk_meta.sqlType)
+          max_val = _datum_to_py(c_chunk_meta.chunkStats.max, c_chunk_meta.sqlType)
+          columns[name] = {
+            "min": min_val,
+            "max": max_val,
+            "has_nulls": c_chunk_meta.chunkStats.has_nulls,
+            "num_bytes": c_chunk_meta.numBytes,
+            "distinct_upper_bound": _distinct_upper_bound(min_val, max_val, c_chunk_meta.numElements),
+          }
+        preincrement(chunk_it)
+      res.append({
+        "fragment_id": dereference(frag_it).fragmentId,
+        "row_count": dereference(frag_it).getPhysicalNumTuples(),
+        "columns": columns,
+      })
+      preincrement(frag_it)
+    return res
 
 cdef class DataMgr:
   def __cinit__(self):
@@ -0,0 +1,6 @@
+#
+# Copyright 2022 Intel Corporation.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+from pyhdk._builder import QueryBuilder, BuilderNode, BuilderExpr, cst, nullCst, countStar
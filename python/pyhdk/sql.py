@@ -3,4 +3,4 @@
 #
 # SPDX-License-Identifier: Apache-2.0
 
-from pyhdk._sql import Calcite, RelAlgExecutor
+from pyhdk._sql import Calcite, RelAlgExecutor, QueryCache
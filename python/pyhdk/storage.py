@@ -3,4 +3,10 @@
 #
 # SPDX-License-Identifier: Apache-2.0
 
-from pyhdk._storage import ArrowStorage, TableOptions, DataMgr
+from pyhdk._storage import (
+    ArrowStorage,
+    TableOptions,
+    CsvParseOptions,
+    JsonParseOptions,
+    DataMgr,
+)
@@ -5,14 +5,40 @@
 #
 # SPDX-License-Identifier: Apache-2.0
 
+import decimal
 import json
+import threading
 import pandas
 import pyarrow
+import pyarrow.dataset
+import pyarrow.parquet
 import pyhdk
 import pytest
 
 
 class TestArrowStorage:
+    @classmethod
+    def setup_class(cls):
+        cls.storage = pyhdk.storage.ArrowStorage(2)
+        cls.data_mgr = pyhdk.storage.DataMgr()
+        cls.data_mgr.registerDataProvider(cls.storage)
+
+        cls.calcite = pyhdk.sql.Calcite(cls.storage)
+        cls.executor = pyhdk.Executor(cls.data_mgr)
+
+    @classmethod
+    def teardown_class(cls):
+        del cls.calcite
+        del cls.storage
+
+    @classmethod
+    def execute_sql(cls, sql, **kwargs):
+        ra = cls.calcite.process(sql)
+        rel_alg_executor = pyhdk.sql.RelAlgExecutor(
+            cls.executor, cls.storage, cls.data_mgr, ra
+        )
+        return rel_alg_executor.execute(**kwargs)
+
     def test_import_arrow_table(self):
         storage = pyhdk.storage.ArrowStorage(123)
         assert storage is not None
@@ -59,6 +85,137 @@ class TestArrowStorage:
         assert columns[2].type.type == "BIGINT"
         assert columns[2].is_rowid == True
 
+        with pytest.raises(RuntimeError):
+            storage.importArrowTable(at, "test1", opt)
+        storage.dropTable("test1")
+        with pytest.raises(RuntimeError):
+            storage.dropTable("test1", True)
+
+    def test_append(self):
+        schema = pyarrow.schema([("x", pyarrow.int64()), ("y", pyarrow.float64())])
+        self.storage.createTable("test_append", schema, pyhdk.storage.TableOptions(2))
+        db_id = self.storage.listDatabases()[0]
+        assert self.storage.getTableInfo(db_id, "test_append").is_stream
+
+        at = pyarrow.Table.from_pydict({"x": [1, 2, 3], "y": [1.5, 2.5, 3.5]}, schema)
+        self.storage.appendArrowTable(at, "test_append")
+        batch = pyarrow.RecordBatch.from_pydict({"x": [4], "y": [4.5]}, schema)
+        self.storage.appendArrowTable(batch, "test_append")
+        reader = pyarrow.RecordBatchReader.from_batches(schema, [batch, batch])
+        self.storage.appendArrowTable(reader, "test_append")
+
+        res = self.execute_sql("SELECT COUNT(*), SUM(x) FROM test_append;")
+        df = res.to_arrow().to_pandas()
+        assert df.iloc[0].tolist() == [6, 18]
+        self.storage.dropTable("test_append")
+
+    def test_append_snapshot(self):
+        schema = pyarrow.schema([("x", pyarrow.int64())])
+        opt = pyhdk.storage.TableOptions(1000)
+        self.storage.createTable("test_snapshot", schema, opt)
+        self.storage.appendArrowTable(
+            pyarrow.Table.from_pydict({"x": [1] * 1500}, schema), "test_snapshot"
+        )
+        at = pyarrow.Table.from_pydict({"x": [2] * 100000}, schema)
+        appender = threading.Thread(
+            target=self.storage.appendArrowTable, args=(at, "test_snapshot")
+        )
+        appender.start()
+        # Every query should see either none or all of the appended rows.
+        results = set()
+        while appender.is_alive() or not results:
+            res = self.execute_sql("SELECT COUNT(*), SUM(x) FROM test_snapshot;")
+            results.add(tuple(res.to_arrow().to_pandas().iloc[0].tolist()))
+        appender.join()
+        assert results <= {(1500, 1500), (101500, 201500)}
+        self.storage.dropTable("test_snapshot")
+
+    def test_fragment_stats(self):
+        at = pyarrow.table(
+            {
+                "a": pyarrow.array([1, 2, 3], pyarrow.int64()),
+                "b": pyarrow.array([10, 20, None], pyarrow.int64()),
+                "d": pyarrow.array(
+                    [decimal.Decimal("1.25"), decimal.Decimal("2.50"), None],
+                    pyarrow.decimal128(10, 2),
+                ),
+            }
+        )
+        self.storage.importArrowTable(at, "test_stats", pyhdk.storage.TableOptions(2))
+        stats = self.storage.getFragmentStats("test_stats")
+        assert [frag["row_count"] for frag in stats] == [2, 1]
+        assert stats[0]["columns"]["a"]["min"] == 1
+        assert stats[0]["columns"]["a"]["max"] == 2
+        assert stats[0]["columns"]["a"]["distinct_upper_bound"] == 2
+        assert not stats[0]["columns"]["b"]["has_nulls"]
+        assert stats[1]["columns"]["b"]["has_nulls"]
+        assert stats[0]["columns"]["d"]["min"] == decimal.Decimal("1.25")
+        assert stats[0]["columns"]["d"]["max"] == decimal.Decimal("2.50")
+        assert stats[0]["columns"]["d"]["distinct_upper_bound"] is None
+        self.storage.dropTable("test_stats")
+
+        with pytest.raises(ValueError, match="Unknown table"):
+            self.storage.getFragmentStats("test_stats")
+
+    def test_fragment_skipping(self):
+        at = pyarrow.table({"x": pyarrow.array(range(3000), pyarrow.int64())})
+        opt = pyhdk.storage.TableOptions(1000)
+        self.storage.importArrowTable(at, "test_skip", opt)
+        # Chunks of skipped fragments are not fetched into the buffer pool. The
+        # filter can match the last fragment only.
+        res = self.execute_sql(
+            "SELECT COUNT(*) FROM test_skip WHERE x >= 2500;", profile=True
+        )
+        assert res.to_arrow().to_pandas().iloc[0].tolist() == [500]
+        selective_bytes = res.profile["fetched_bytes"]["cpu"]
+        # The other two fragments are fetched by a query matching all rows.
+        res = self.execute_sql(
+            "SELECT COUNT(*) FROM test_skip WHERE x >= 0;", profile=True
+        )
+        assert res.to_arrow().to_pandas().iloc[0].tolist() == [3000]
+        full_bytes = res.profile["fetched_bytes"]["cpu"]
+        assert 0 < selective_bytes < full_bytes
+        self.storage.dropTable("test_skip")
+
+    def test_import_files(self, tmp_path):
+        csv_file = tmp_path / "test.csv"
+        csv_file.write_text("skipped\nx|y\n1|1.5\n2|2.5\n3|3.5\n")
+        parse_options = pyhdk.storage.CsvParseOptions(delimiter="|", skip_rows=1)
+        self.storage.importCsvFile(
+            str(csv_file), "test_csv", pyhdk.storage.TableOptions(2), parse_options
+        )
+        res = self.execute_sql("SELECT SUM(x), SUM(y) FROM test_csv;")
+        assert res.to_arrow().to_pandas().iloc[0].tolist() == [6, 7.5]
+        self.storage.dropTable("test_csv")
+
+        json_file = tmp_path / "test.json"
+        json_file.write_text('{"x": 1, "y": 1.5}\n{"x": 2, "y": 2.5}\n')
+        self.storage.importJsonFile(
+            str(json_file), "test_json", pyhdk.storage.TableOptions(2)
+        )
+        res = self.execute_sql("SELECT SUM(x), SUM(y) FROM test_json;")
+        assert res.to_arrow().to_pandas().iloc[0].tolist() == [3, 4.0]
+        self.storage.dropTable("test_json")
+
+        parquet_file = tmp_path / "test.parquet"
+        at = pyarrow.Table.from_pydict(
+            {"x": list(range(10)), "y": [1.5] * 10, "z": ["a"] * 10}
+        )
+        pyarrow.parquet.write_table(at, str(parquet_file), row_group_size=3)
+        self.storage.importParquetFile(
+            str(parquet_file),
+            "test_parquet",
+            pyhdk.storage.TableOptions(2),
+            columns=["x", "y"],
+            filter=pyarrow.dataset.field("x") >= 7,
+        )
+        db_id = self.storage.listDatabases()[0]
+        columns = self.storage.listColumns(db_id, "test_parquet")
+        assert [col.name for col in columns] == ["x", "y", "rowid"]
+        res = self.execute_sql("SELECT COUNT(*), SUM(x) FROM test_parquet;")
+        assert res.to_arrow().to_pandas().iloc[0].tolist() == [3, 24]
+        self.storage.dropTable("test_parquet")
+
 
 class TestCalcite:
     @classmethod
@@ -7,6 +7,7 @@
 
 
 import json
+from concurrent.futures import ThreadPoolExecutor
 import pandas
 import pyarrow
 import pytest
@@ -49,7 +50,227 @@ class TestSql:
         assert df["a"].tolist() == [1, 2, 3]
         assert df["b"].tolist() == [10, 20, 30]
 
+    def test_columnar_export(self):
+        res = self.execute_sql("SELECT * FROM test;", enable_columnar_output=True)
+        at = res.to_arrow()
+        del res
+        df = at.to_pandas()
+        assert df["a"].tolist() == [1, 2, 3]
+        assert df["b"].tolist() == [10, 20, 30]
+
+    def test_profile(self):
+        res = self.execute_sql("SELECT a FROM test WHERE b > 15;")
+        res.to_arrow()
+        profile = res.profile
+        assert profile["result_rows"] == 2
+        for phase in ("dag_build_ms", "execution_ms", "arrow_conversion_ms"):
+            assert profile[phase] > 0
+        assert profile["arrow_bytes"] > 0
+        assert profile["peak_rss_mb"] > 0
+        # Calcite is called outside of RelAlgExecutor and is not measured.
+        assert "calcite_ms" not in profile
+        assert "timers" not in profile
+        assert json.loads(json.dumps(profile)) == profile
+
+        res = self.execute_sql("SELECT a FROM test WHERE b > 15;", profile=True)
+        assert set(res.profile["fetched_bytes"]) == {"cpu", "gpu"}
+        assert all(val >= 0 for val in res.profile["fetched_bytes"].values())
+        assert "timers" not in res.profile
+        assert json.loads(json.dumps(res.profile)) == res.profile
+
+        pyhdk.setGlobalConfig(enable_debug_timer=True)
+        try:
+            res = self.execute_sql("SELECT a FROM test WHERE b > 15;")
+        finally:
+            pyhdk.setGlobalConfig(enable_debug_timer=False)
+        assert res.profile["timers"]
+        assert json.loads(json.dumps(res.profile)) == res.profile
+
+    def test_threads(self):
+        queries = [
+            "SELECT a FROM test WHERE b > 15;",
+            "SELECT SUM(b) AS s FROM test;",
+            "SELECT a, b FROM test ORDER BY a DESC;",
+        ]
+        executors = [
+            pyhdk.sql.RelAlgExecutor(
+                self.executor, self.storage, self.data_mgr, self.calcite.process(sql)
+            )
+            for sql in queries
+        ]
+        with ThreadPoolExecutor(max_workers=3) as pool:
+            results = list(pool.map(lambda executor: executor.execute(), executors))
+        dfs = [res.to_arrow().to_pandas() for res in results]
+        assert dfs[0]["a"].tolist() == [2, 3]
+        assert dfs[1]["s"].tolist() == [60]
+        assert dfs[2]["a"].tolist() == [3, 2, 1]
+
     def test_explain(self):
         res = self.execute_sql("SELECT * FROM test;", just_explain = True)
         explain_str = res.to_explain_str()
         assert (explain_str[:15] == "IR for the CPU:")
+
+    def test_query_cache(self):
+        cache = pyhdk.sql.QueryCache(
+            self.calcite, self.executor, self.storage, self.data_mgr
+        )
+        res = cache.execute("SELECT a FROM test WHERE b > 15;")
+        assert res.to_arrow().to_pandas()["a"].tolist() == [2, 3]
+        assert res.profile["calcite_ms"] > 0
+        res = cache.execute("SELECT a\n  FROM   test WHERE b > 15")
+        assert res.to_arrow().to_pandas()["a"].tolist() == [2, 3]
+        assert res.profile["plan_cache_hit"]
+        assert "calcite_ms" not in res.profile
+        assert "dag_build_ms" not in res.profile
+        assert cache.hits == 1
+        assert cache.misses == 1
+        assert len(cache) == 1
+
+        # The second query of the same shape creates a plan template.
+        res = cache.execute("SELECT a FROM test WHERE b > 25;")
+        assert res.to_arrow().to_pandas()["a"].tolist() == [3]
+        assert not res.profile["plan_template_hit"]
+        assert res.profile["calcite_ms"] > 0
+        assert res.profile["plan_template_ms"] > 0
+
+        # Next queries of the same shape reuse the plan without Calcite.
+        res = cache.execute("SELECT a FROM test WHERE b > 5;")
+        assert res.to_arrow().to_pandas()["a"].tolist() == [1, 2, 3]
+        assert not res.profile["plan_cache_hit"]
+        assert res.profile["plan_template_hit"]
+        assert "plan_bind_ms" in res.profile
+        assert "calcite_ms" not in res.profile
+        assert cache.template_hits == 1
+        assert len(cache) == 3
+
+        sql = "SELECT a FROM test WHERE b > 15;"
+        assert cache.prepare(sql, legacy_syntax=True) is not cache.prepare(sql)
+        assert cache.prepare(sql, legacy_syntax=True) is cache.prepare(
+            sql, legacy_syntax=True
+        )
+        assert len(cache) == 4
+        cache.clear()
+
+        at = pyarrow.Table.from_pandas(pandas.DataFrame({"x": [1, 2]}))
+        self.storage.importArrowTable(at, "test_cache", pyhdk.storage.TableOptions(2))
+        res = cache.execute("SELECT a FROM test WHERE b > 15;")
+        assert res.to_arrow().to_pandas()["a"].tolist() == [2, 3]
+        assert cache.hits == 4
+        assert cache.misses == 5
+        assert len(cache) == 1
+        self.storage.dropTable("test_cache")
+
+    def test_query_cache_threads(self):
+        cache = pyhdk.sql.QueryCache(
+            self.calcite, self.executor, self.storage, self.data_mgr
+        )
+        queries = [f"SELECT a FROM test WHERE b > {i % 3};" for i in range(12)]
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            results = list(pool.map(cache.execute, queries))
+        assert sum(res.profile["plan_cache_hit"] for res in results) == cache.hits
+        assert cache.hits + cache.misses == len(queries)
+        assert cache.misses == 3
+        assert len(cache) == 3
+
+
+class TestBuilder:
+    @classmethod
+    def setup_class(cls):
+        cls.storage = pyhdk.storage.ArrowStorage(1)
+        cls.data_mgr = pyhdk.storage.DataMgr()
+        cls.data_mgr.registerDataProvider(cls.storage)
+
+        cls.executor = pyhdk.Executor(cls.data_mgr)
+        cls.builder = pyhdk.builder.QueryBuilder(cls.storage)
+
+        at = pyarrow.Table.from_pandas(
+            pandas.DataFrame({"a": [1, 2, 3], "b": [10, 20, 30]})
+        )
+        opt = pyhdk.storage.TableOptions(2)
+        cls.storage.importArrowTable(at, "test", opt)
+
+    @classmethod
+    def teardown_class(cls):
+        del cls.builder
+        del cls.storage
+
+    @classmethod
+    def execute_node(cls, node, **kwargs):
+        dag = cls.builder.finalize(node)
+        rel_alg_executor = pyhdk.sql.RelAlgExecutor(
+            cls.executor, cls.storage, cls.data_mgr, dag
+        )
+        return rel_alg_executor.execute(**kwargs)
+
+    def test_profile(self):
+        scan = self.builder.scan("test")
+        res = self.execute_node(scan.proj([scan["a"]]))
+        assert res.profile["dag_build_ms"] > 0
+        assert "calcite_ms" not in res.profile
+
+    def test_projection_sort(self):
+        scan = self.builder.scan("test")
+        proj = scan.proj([scan["a"], (scan["a"] + scan["b"]).rename("s")])
+        res = self.execute_node(proj.sort([("s", "desc")]))
+        df = res.to_arrow().to_pandas()
+        assert df["a"].tolist() == [3, 2, 1]
+        assert df["s"].tolist() == [33, 22, 11]
+
+    def test_sort_fields(self):
+        scan = self.builder.scan("test")
+        res = self.execute_node(scan.sort([("a", "ASC")]))
+        assert res.to_arrow().to_pandas()["a"].tolist() == [1, 2, 3]
+        res = self.execute_node(scan.sort([("b", "desc", "last")]))
+        assert res.to_arrow().to_pandas()["b"].tolist() == [30, 20, 10]
+        with pytest.raises(ValueError):
+            scan.sort([("a", "ascending")])
+        with pytest.raises(ValueError):
+            scan.sort([("a", "asc", "middle")])
+
+    def test_scan_fields(self):
+        scan = self.builder.scan("test")
+        assert scan.fieldNames == ["a", "b"]
+        res = self.execute_node(scan.sort([("a", "desc")]))
+        df = res.to_arrow().to_pandas()
+        assert df.columns.tolist() == ["a", "b"]
+        assert df["a"].tolist() == [3, 2, 1]
+        res = self.execute_node(scan.filter(scan["b"] > 15))
+        assert res.to_arrow().column_names == ["a", "b"]
+
+    def test_unique_names(self):
+        scan = self.builder.scan("test")
+        proj = scan.proj([scan["a"], scan["a"], scan["a"] + 1, scan["b"] + 1])
+        assert proj.fieldNames == ["a", "a_1", "expr", "expr_1"]
+        res = self.execute_node(proj.sort(["a"]))
+        df = res.to_arrow().to_pandas()
+        assert df.columns.tolist() == ["a", "a_1", "expr", "expr_1"]
+        assert df["expr_1"].tolist() == [11, 21, 31]
+        join = scan.join(proj, scan["a"] == proj["a"])
+        assert join.fieldNames == ["a", "b", "a_2", "a_1", "expr", "expr_1"]
+
+    def test_filter_aggregate(self):
+        scan = self.builder.scan("test")
+        filt = scan.filter(scan["b"] > 15)
+        res = self.execute_node(
+            filt.agg([], [scan["a"].sum(), pyhdk.builder.countStar()])
+        )
+        df = res.to_arrow().to_pandas()
+        assert df["sum_a"].tolist() == [5]
+        assert df["count"].tolist() == [2]
+
+    def test_join(self):
+        scan = self.builder.scan("test")
+        rhs = scan.proj([scan["a"].rename("ra"), (scan["b"] * 2).rename("b2")])
+        join = scan.join(rhs, scan["a"] == rhs["ra"])
+        res = self.execute_node(join.proj([scan["a"], rhs["b2"]]).sort(["a"]))
+        df = res.to_arrow().to_pandas()
+        assert df["a"].tolist() == [1, 2, 3]
+        assert df["b2"].tolist() == [20, 40, 60]
+
+    def test_ambiguous_join_ref(self):
+        scan = self.builder.scan("test")
+        with pytest.raises(RuntimeError, match="Ambiguous column reference"):
+            scan.join(scan, scan["a"] == scan["b"])
+        filt = scan.filter(scan["b"] > 15)
+        with pytest.raises(RuntimeError, match="Ambiguous column reference"):
+            scan.join(filt, scan["a"] == filt["a"])
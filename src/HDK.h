@@ -5,3 +5,4 @@
  */
  
 #include "Expression/Expression.h"
+#include "QueryBuilder/QueryBuilder.h"
@@ -0,0 +1,824 @@
+/**
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "QueryBuilder.h"
+
+#include "QueryEngine/RelAlgDagBuilder.h"
+#include "QueryEngine/RelAlgOptimizer.h"
+#include "QueryEngine/RelLeftDeepInnerJoin.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace hdk {
+
+namespace {
+
+std::atomic<int> next_node_id{0};
+
+const char* opName(SQLOps op) {
+  switch (op) {
+    case kAND:
+      return "AND";
+    case kOR:
+      return "OR";
+    case kPLUS:
+      return "+";
+    case kMINUS:
+      return "-";
+    case kMULTIPLY:
+      return "*";
+    case kDIVIDE:
+      return "/";
+    case kMODULO:
+      return "MOD";
+    default:
+      break;
+  }
+  return "operator";
+}
+
+SQLTypeInfo commonArithType(const SQLTypeInfo& lhs, const SQLTypeInfo& rhs) {
+  bool nullable = !lhs.get_notnull() || !rhs.get_notnull();
+  if (lhs.get_type() == rhs.get_type() && !lhs.is_decimal()) {
+    return SQLTypeInfo(lhs.get_type(), !nullable);
+  }
+  if (lhs.is_fp() || rhs.is_fp() || lhs.is_decimal() || rhs.is_decimal()) {
+    return SQLTypeInfo(kDOUBLE, !nullable);
+  }
+  if (lhs.is_integer() && rhs.is_integer()) {
+    return SQLTypeInfo(lhs.get_size() >= rhs.get_size() ? lhs.get_type() : rhs.get_type(),
+                       !nullable);
+  }
+  throw std::runtime_error("Incompatible operand types: " + lhs.toString() + " and " +
+                           rhs.toString());
+}
+
+// Make output names unique, e.g. when the same column is projected twice or
+// several expressions keep the default "expr" name.
+std::vector<std::string> uniqueNames(const std::vector<std::string>& names) {
+  std::unordered_set<std::string> taken(names.begin(), names.end());
+  std::unordered_set<std::string> used;
+  std::vector<std::string> res;
+  for (auto& name : names) {
+    if (used.insert(name).second) {
+      res.push_back(name);
+      continue;
+    }
+    for (size_t i = 1;; ++i) {
+      auto candidate = name + "_" + std::to_string(i);
+      if (!taken.count(candidate) && used.insert(candidate).second) {
+        res.push_back(candidate);
+        break;
+      }
+    }
+  }
+  return res;
+}
+
+}  // namespace
+
+namespace detail {
+
+enum class NodeKind { kScan, kProject, kFilter, kAggregate, kSort, kJoin };
+
+struct BuilderNodeData {
+  int id;
+  NodeKind kind;
+  std::vector<std::shared_ptr<const BuilderNodeData>> inputs;
+  // Visible output columns. Scans also output the rowid column, which is not
+  // listed here.
+  std::vector<std::string> fields;
+  std::vector<SQLTypeInfo> types;
+  // Scan
+  TableInfoPtr table_info;
+  std::vector<ColumnInfoPtr> column_infos;
+  // Project
+  std::vector<BuilderExpr> exprs;
+  // Filter and Join
+  BuilderExpr condition;
+  JoinType join_type = JoinType::INNER;
+  // Aggregate
+  size_t group_size = 0;
+  std::vector<BuilderExpr> aggs;
+  // Sort
+  std::vector<BuilderSortField> collation;
+  size_t limit = 0;
+  size_t offset = 0;
+};
+
+}  // namespace detail
+
+BuilderExpr::BuilderExpr()
+    : BuilderExpr(Kind::kLiteral, SQLTypeInfo(kNULLT, false), "") {}
+
+BuilderExpr::BuilderExpr(Kind kind, const SQLTypeInfo& type, const std::string& name)
+    : kind_(kind)
+    , type_(type)
+    , name_(name)
+    , node_id_(-1)
+    , col_idx_(0)
+    , op_(kEQ)
+    , agg_(kCOUNT)
+    , is_distinct_(false) {}
+
+BuilderExpr BuilderExpr::cst(int val) {
+  return cst(static_cast<int64_t>(val));
+}
+
+BuilderExpr BuilderExpr::cst(int64_t val) {
+  bool is_int32 = val >= std::numeric_limits<int32_t>::min() &&
+                  val <= std::numeric_limits<int32_t>::max();
+  BuilderExpr res(Kind::kLiteral, SQLTypeInfo(is_int32 ? kINT : kBIGINT, true), "cst");
+  res.value_ = val;
+  return res;
+}
+
+BuilderExpr BuilderExpr::cst(double val) {
+  BuilderExpr res(Kind::kLiteral, SQLTypeInfo(kDOUBLE, true), "cst");
+  res.value_ = val;
+  return res;
+}
+
+BuilderExpr BuilderExpr::cst(bool val) {
+  BuilderExpr res(Kind::kLiteral, SQLTypeInfo(kBOOLEAN, true), "cst");
+  res.value_ = val;
+  return res;
+}
+
+BuilderExpr BuilderExpr::cst(const std::string& val) {
+  BuilderExpr res(Kind::kLiteral, SQLTypeInfo(kTEXT, true), "cst");
+  res.value_ = val;
+  return res;
+}
+
+BuilderExpr BuilderExpr::cst(const char* val) {
+  return cst(std::string(val));
+}
+
+BuilderExpr BuilderExpr::nullCst(const SQLTypeInfo& type) {
+  SQLTypeInfo nullable_type = type;
+  nullable_type.set_notnull(false);
+  return BuilderExpr(Kind::kLiteral, nullable_type, "cst");
+}
+
+BuilderExpr BuilderExpr::countStar() {
+  BuilderExpr res(Kind::kAggregate, SQLTypeInfo(kBIGINT, true), "count");
+  res.agg_ = kCOUNT;
+  return res;
+}
+
+BuilderExpr BuilderExpr::rename(const std::string& name) const {
+  BuilderExpr res = *this;
+  res.name_ = name;
+  return res;
+}
+
+BuilderExpr BuilderExpr::eq(const BuilderExpr& rhs) const {
+  return cmpOp(kEQ, rhs);
+}
+
+BuilderExpr BuilderExpr::ne(const BuilderExpr& rhs) const {
+  return cmpOp(kNE, rhs);
+}
+
+BuilderExpr BuilderExpr::lt(const BuilderExpr& rhs) const {
+  return cmpOp(kLT, rhs);
+}
+
+BuilderExpr BuilderExpr::le(const BuilderExpr& rhs) const {
+  return cmpOp(kLE, rhs);
+}
+
+BuilderExpr BuilderExpr::gt(const BuilderExpr& rhs) const {
+  return cmpOp(kGT, rhs);
+}
+
+BuilderExpr BuilderExpr::ge(const BuilderExpr& rhs) const {
+  return cmpOp(kGE, rhs);
+}
+
+BuilderExpr BuilderExpr::logicalAnd(const BuilderExpr& rhs) const {
+  return logicalOp(kAND, rhs);
+}
+
+BuilderExpr BuilderExpr::logicalOr(const BuilderExpr& rhs) const {
+  return logicalOp(kOR, rhs);
+}
+
+BuilderExpr BuilderExpr::logicalNot() const {
+  if (!type_.is_boolean()) {
+    throw std::runtime_error("NOT operand should be boolean, got " + type_.toString());
+  }
+  return unaryOp(kNOT, SQLTypeInfo(kBOOLEAN, type_.get_notnull()));
+}
+
+BuilderExpr BuilderExpr::isNull() const {
+  return unaryOp(kISNULL, SQLTypeInfo(kBOOLEAN, true));
+}
+
+BuilderExpr BuilderExpr::isNotNull() const {
+  return unaryOp(kISNOTNULL, SQLTypeInfo(kBOOLEAN, true));
+}
+
+BuilderExpr BuilderExpr::add(const BuilderExpr& rhs) const {
+  return arithOp(kPLUS, rhs);
+}
+
+BuilderExpr BuilderExpr::sub(const BuilderExpr& rhs) const {
+  return arithOp(kMINUS, rhs);
+}
+
+BuilderExpr BuilderExpr::mul(const BuilderExpr& rhs) const {
+  return arithOp(kMULTIPLY, rhs);
+}
+
+BuilderExpr BuilderExpr::div(const BuilderExpr& rhs) const {
+  return arithOp(kDIVIDE, rhs);
+}
+
+BuilderExpr BuilderExpr::mod(const BuilderExpr& rhs) const {
+  return arithOp(kMODULO, rhs);
+}
+
+BuilderExpr BuilderExpr::cast(const SQLTypeInfo& type) const {
+  SQLTypeInfo res_type = type;
+  res_type.set_notnull(type_.get_notnull());
+  return unaryOp(kCAST, res_type);
+}
+
+BuilderExpr BuilderExpr::count(bool is_distinct) const {
+  return aggregate(kCOUNT, "COUNT", SQLTypeInfo(kBIGINT, true), is_distinct);
+}
+
+BuilderExpr BuilderExpr::sum() const {
+  if (!type_.is_number()) {
+    throw std::runtime_error("SUM operand should be numeric, got " + type_.toString());
+  }
+  SQLTypeInfo res_type = type_.is_integer() ? SQLTypeInfo(kBIGINT, false) : type_;
+  res_type.set_notnull(false);
+  return aggregate(kSUM, "SUM", res_type, false);
+}
+
+BuilderExpr BuilderExpr::avg() const {
+  if (!type_.is_number()) {
+    throw std::runtime_error("AVG operand should be numeric, got " + type_.toString());
+  }
+  return aggregate(kAVG, "AVG", SQLTypeInfo(kDOUBLE, false), false);
+}
+
+BuilderExpr BuilderExpr::min() const {
+  SQLTypeInfo res_type = type_;
+  res_type.set_notnull(false);
+  return aggregate(kMIN, "MIN", res_type, false);
+}
+
+BuilderExpr BuilderExpr::max() const {
+  SQLTypeInfo res_type = type_;
+  res_type.set_notnull(false);
+  return aggregate(kMAX, "MAX", res_type, false);
+}
+
+BuilderExpr BuilderExpr::cmpOp(SQLOps op, const BuilderExpr& rhs) const {
+  BuilderExpr res(Kind::kOperator,
+                  SQLTypeInfo(kBOOLEAN, type_.get_notnull() && rhs.type_.get_notnull()),
+                  "expr");
+  res.op_ = op;
+  res.operands_ = {*this, rhs};
+  return res;
+}
+
+BuilderExpr BuilderExpr::logicalOp(SQLOps op, const BuilderExpr& rhs) const {
+  if (!type_.is_boolean() || !rhs.type_.is_boolean()) {
+    throw std::runtime_error(std::string(opName(op)) + " operands should be boolean, " +
+                             "got " + type_.toString() + " and " + rhs.type_.toString());
+  }
+  return cmpOp(op, rhs);
+}
+
+BuilderExpr BuilderExpr::arithOp(SQLOps op, const BuilderExpr& rhs) const {
+  if (!type_.is_number() || !rhs.type_.is_number()) {
+    throw std::runtime_error(std::string(opName(op)) + " operands should be numeric, " +
+                             "got " + type_.toString() + " and " + rhs.type_.toString());
+  }
+  BuilderExpr res(Kind::kOperator, commonArithType(type_, rhs.type_), "expr");
+  res.op_ = op;
+  res.operands_ = {*this, rhs};
+  return res;
+}
+
+BuilderExpr BuilderExpr::unaryOp(SQLOps op, const SQLTypeInfo& type) const {
+  BuilderExpr res(Kind::kOperator, type, "expr");
+  res.op_ = op;
+  res.operands_ = {*this};
+  return res;
+}
+
+BuilderExpr BuilderExpr::aggregate(SQLAgg agg,
+                                   const std::string& agg_name,
+                                   const SQLTypeInfo& type,
+                                   bool is_distinct) const {
+  if (kind_ == Kind::kAggregate) {
+    throw std::runtime_error("Nested aggregates are not allowed: " + agg_name);
+  }
+  std::string name = agg_name + "_" + name_;
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  BuilderExpr res(Kind::kAggregate, type, name);
+  res.agg_ = agg;
+  res.is_distinct_ = is_distinct;
+  res.operands_ = {*this};
+  return res;
+}
+
+namespace {
+
+using NodeDataPtr = std::shared_ptr<const detail::BuilderNodeData>;
+
+// Collect positions of the referenced column in the node output. The same
+// node can be reached through several join inputs, so multiple positions are
+// possible.
+void findColumn(const NodeDataPtr& node,
+                int node_id,
+                size_t col_idx,
+                size_t offset,
+                std::vector<size_t>& res) {
+  if (node->id == node_id) {
+    res.push_back(offset + col_idx);
+    return;
+  }
+  // Filter and sort keep input columns and join concatenates them, so
+  // references to columns of their inputs are allowed.
+  if (node->kind == detail::NodeKind::kFilter || node->kind == detail::NodeKind::kSort) {
+    findColumn(node->inputs.front(), node_id, col_idx, offset, res);
+  } else if (node->kind == detail::NodeKind::kJoin) {
+    for (auto& input : node->inputs) {
+      findColumn(input, node_id, col_idx, offset, res);
+      offset += input->fields.size();
+    }
+  }
+}
+
+std::shared_ptr<detail::BuilderNodeData> makeNode(detail::NodeKind kind,
+                                                  std::vector<NodeDataPtr> inputs) {
+  auto node = std::make_shared<detail::BuilderNodeData>();
+  node->id = next_node_id++;
+  node->kind = kind;
+  node->inputs = std::move(inputs);
+  return node;
+}
+
+}  // namespace
+
+BuilderNode::BuilderNode() {}
+
+BuilderNode::BuilderNode(std::shared_ptr<const detail::BuilderNodeData> node)
+    : node_(std::move(node)) {}
+
+const detail::BuilderNodeData& BuilderNode::data() const {
+  if (!node_) {
+    throw std::runtime_error("Uninitialized query builder node");
+  }
+  return *node_;
+}
+
+size_t BuilderNode::size() const {
+  return data().fields.size();
+}
+
+const std::vector<std::string>& BuilderNode::fieldNames() const {
+  return data().fields;
+}
+
+BuilderExpr BuilderNode::ref(size_t col_idx) const {
+  if (col_idx >= size()) {
+    throw std::runtime_error("Column index is out of range: " + std::to_string(col_idx));
+  }
+  BuilderExpr res(
+      BuilderExpr::Kind::kColumnRef, node_->types[col_idx], node_->fields[col_idx]);
+  res.node_id_ = node_->id;
+  res.col_idx_ = col_idx;
+  return res;
+}
+
+BuilderExpr BuilderNode::ref(const std::string& col_name) const {
+  auto& fields = data().fields;
+  auto it = std::find(fields.begin(), fields.end(), col_name);
+  if (it == fields.end()) {
+    throw std::runtime_error("Unknown column: " + col_name);
+  }
+  return ref(static_cast<size_t>(it - fields.begin()));
+}
+
+BuilderExpr BuilderNode::resolve(const BuilderExpr& expr,
+                                 const std::vector<NodeDataPtr>& inputs) {
+  BuilderExpr res = expr;
+  if (expr.kind_ == BuilderExpr::Kind::kColumnRef) {
+    if (expr.node_id_ < 0) {
+      throw std::runtime_error("Cannot use resolved column reference: " + expr.name_);
+    }
+    std::vector<size_t> positions;
+    size_t offset = 0;
+    for (auto& input : inputs) {
+      findColumn(input, expr.node_id_, expr.col_idx_, offset, positions);
+      offset += input->fields.size();
+    }
+    if (positions.empty()) {
+      throw std::runtime_error("Column reference doesn't belong to the node input: " +
+                               expr.name_);
+    }
+    // E.g. a self-join of a scan, where the reference could mean a column of
+    // either side. References should be taken from distinct join inputs.
+    if (positions.size() > 1) {
+      throw std::runtime_error("Ambiguous column reference: " + expr.name_ +
+                               " is reachable from multiple inputs");
+    }
+    res.node_id_ = -1;
+    res.col_idx_ = positions.front();
+    return res;
+  }
+  for (auto& operand : res.operands_) {
+    operand = resolve(operand, inputs);
+  }
+  return res;
+}
+
+BuilderNode BuilderNode::proj(const std::vector<BuilderExpr>& exprs) const {
+  if (exprs.empty()) {
+    throw std::runtime_error("Projection should have at least one expression");
+  }
+  auto node = makeNode(detail::NodeKind::kProject, {node_});
+  for (auto& expr : exprs) {
+    if (expr.isAggregate()) {
+      throw std::runtime_error("Aggregate is not allowed in projection: " + expr.name());
+    }
+    node->exprs.push_back(resolve(expr, node->inputs));
+    node->fields.push_back(expr.name());
+    node->types.push_back(expr.type());
+  }
+  node->fields = uniqueNames(node->fields);
+  return BuilderNode(node);
+}
+
+BuilderNode BuilderNode::filter(const BuilderExpr& condition) const {
+  if (condition.isAggregate() || !condition.type().is_boolean()) {
+    throw std::runtime_error("Filter condition should be a boolean expression: " +
+                             condition.name());
+  }
+  auto node = makeNode(detail::NodeKind::kFilter, {node_});
+  node->condition = resolve(condition, node->inputs);
+  node->fields = data().fields;
+  node->types = data().types;
+  return BuilderNode(node);
+}
+
+BuilderNode BuilderNode::agg(const std::vector<BuilderExpr>& group_keys,
+                             const std::vector<BuilderExpr>& aggs) const {
+  if (group_keys.empty() && aggs.empty()) {
+    throw std::runtime_error("Aggregation should have group keys or aggregates");
+  }
+  // RelAggregate expects group keys to be the leading input columns, so
+  // project keys and aggregate operands first like Calcite does.
+  std::vector<BuilderExpr> proj_exprs = group_keys;
+  for (auto& agg_expr : aggs) {
+    if (!agg_expr.isAggregate()) {
+      throw std::runtime_error("Expected aggregate expression: " + agg_expr.name());
+    }
+    for (auto& operand : agg_expr.operands_) {
+      proj_exprs.push_back(operand.rename("$f" + std::to_string(proj_exprs.size())));
+    }
+  }
+  // COUNT(*) without group keys still needs some input column.
+  if (proj_exprs.empty()) {
+    proj_exprs.push_back(ref(0));
+  }
+  auto input = proj(proj_exprs);
+
+  auto node = makeNode(detail::NodeKind::kAggregate, {input.node_});
+  node->group_size = group_keys.size();
+  for (auto& key : group_keys) {
+    if (key.isAggregate()) {
+      throw std::runtime_error("Aggregate is not allowed as a group key: " + key.name());
+    }
+    node->fields.push_back(key.name());
+    node->types.push_back(key.type());
+  }
+  size_t operand_idx = group_keys.size();
+  for (auto& agg_expr : aggs) {
+    BuilderExpr resolved = agg_expr;
+    for (auto& operand : resolved.operands_) {
+      operand = input.ref(operand_idx++);
+      operand.node_id_ = -1;
+    }
+    node->aggs.push_back(resolved);
+    node->fields.push_back(agg_expr.name());
+    node->types.push_back(agg_expr.type());
+  }
+  node->fields = uniqueNames(node->fields);
+  return BuilderNode(node);
+}
+
+BuilderNode BuilderNode::sort(const std::vector<BuilderSortField>& fields,
+                              size_t limit,
+                              size_t offset) const {
+  auto node = makeNode(detail::NodeKind::kSort, {node_});
+  for (auto& field : fields) {
+    auto col = resolve(field.col, node->inputs);
+    if (col.kind_ != BuilderExpr::Kind::kColumnRef) {
+      throw std::runtime_error("Only column references are allowed as sort keys: " +
+                               field.col.name());
+    }
+    node->collation.emplace_back(col, field.ascending, field.nulls_first);
+  }
+  node->limit = limit;
+  node->offset = offset;
+  node->fields = data().fields;
+  node->types = data().types;
+  return BuilderNode(node);
+}
+
+BuilderNode BuilderNode::join(const BuilderNode& rhs,
+                              const BuilderExpr& condition,
+                              JoinType join_type) const {
+  if (join_type != JoinType::INNER && join_type != JoinType::LEFT) {
+    throw std::runtime_error("Only inner and left joins are supported");
+  }
+  if (condition.isAggregate() || !condition.type().is_boolean()) {
+    throw std::runtime_error("Join condition should be a boolean expression: " +
+                             condition.name());
+  }
+  auto node = makeNode(detail::NodeKind::kJoin, {node_, rhs.node_});
+  node->condition = resolve(condition, node->inputs);
+  node->join_type = join_type;
+  node->fields = data().fields;
+  auto& rhs_fields = rhs.data().fields;
+  node->fields.insert(node->fields.end(), rhs_fields.begin(), rhs_fields.end());
+  node->fields = uniqueNames(node->fields);
+  node->types = data().types;
+  for (auto type : rhs.data().types) {
+    // Right side columns get NULLs for unmatched rows in the left join.
+    if (join_type == JoinType::LEFT) {
+      type.set_notnull(false);
+    }
+    node->types.push_back(type);
+  }
+  return BuilderNode(node);
+}
+
+namespace detail {
+
+/**
+ * Creates RelAlg nodes and expressions for built nodes. Nodes are collected in
+ * post-order with shared inputs created once, as RelAlgDag expects.
+ */
+class RelAlgNodeFactory {
+ public:
+  std::vector<std::shared_ptr<RelAlgNode>> build(const NodeDataPtr& root) {
+    auto res = makeNode(root);
+    // Executor needs a projection over scans and joins to produce the result,
+    // it also drops the hidden rowid column.
+    if (needsProject(root, res)) {
+      project(res, root->fields);
+    }
+    return std::move(nodes_);
+  }
+
+ private:
+  // Built RelAlg node and positions of the visible columns in its output.
+  struct BuiltNode {
+    std::shared_ptr<RelAlgNode> node;
+    std::vector<size_t> positions;
+  };
+
+  static bool needsProject(const NodeDataPtr& node, const BuiltNode& built) {
+    if (node->kind == NodeKind::kScan || node->kind == NodeKind::kJoin ||
+        built.positions.size() != built.node->size()) {
+      return true;
+    }
+    for (size_t i = 0; i < built.positions.size(); ++i) {
+      if (built.positions[i] != i) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  BuiltNode makeNode(const NodeDataPtr& node) {
+    auto it = built_.find(node.get());
+    if (it != built_.end()) {
+      return it->second;
+    }
+
+    std::vector<BuiltNode> inputs;
+    for (auto& input : node->inputs) {
+      inputs.push_back(makeNode(input));
+    }
+
+    BuiltNode res;
+    switch (node->kind) {
+      case NodeKind::kScan:
+        res.node = std::make_shared<RelScan>(node->table_info, node->column_infos);
+        for (size_t i = 0; i < node->column_infos.size(); ++i) {
+          if (!node->column_infos[i]->is_rowid) {
+            res.positions.push_back(i);
+          }
+        }
+        break;
+      case NodeKind::kProject: {
+        std::vector<std::unique_ptr<const RexScalar>> exprs;
+        for (auto& expr : node->exprs) {
+          exprs.push_back(makeRex(expr, inputs));
+        }
+        res.node = std::make_shared<RelProject>(exprs, node->fields, inputs[0].node);
+        res.positions = identity(node->fields.size());
+        break;
+      }
+      case NodeKind::kFilter: {
+        auto condition = makeRex(node->condition, inputs);
+        res.node = std::make_shared<RelFilter>(condition, inputs[0].node);
+        res.positions = inputs[0].positions;
+        break;
+      }
+      case NodeKind::kAggregate: {
+        std::vector<std::unique_ptr<const RexAgg>> aggs;
+        for (auto& agg : node->aggs) {
+          std::vector<size_t> operands;
+          for (auto& operand : agg.operands_) {
+            operands.push_back(inputs[0].positions[operand.col_idx_]);
+          }
+          aggs.push_back(
+              std::make_unique<RexAgg>(agg.agg_, agg.is_distinct_, agg.type_, operands));
+        }
+        res.node = std::make_shared<RelAggregate>(
+            node->group_size, aggs, node->fields, inputs[0].node);
+        res.positions = identity(node->fields.size());
+        break;
+      }
+      case NodeKind::kSort: {
+        // Sort input is executed as a separate step, which cannot be a scan or
+        // a join.
+        auto input = inputs[0];
+        if (needsProject(node->inputs[0], input)) {
+          input = project(input, node->inputs[0]->fields);
+        }
+        std::vector<SortField> collation;
+        for (auto& field : node->collation) {
+          collation.emplace_back(
+              input.positions[field.col.col_idx_],
+              field.ascending ? SortDirection::Ascending : SortDirection::Descending,
+              field.nulls_first ? NullSortedPosition::First : NullSortedPosition::Last);
+        }
+        res.node = std::make_shared<RelSort>(
+            collation, node->limit, node->offset, input.node);
+        res.positions = input.positions;
+        break;
+      }
+      case NodeKind::kJoin: {
+        auto condition = makeRex(node->condition, inputs);
+        res.node = std::make_shared<RelJoin>(
+            inputs[0].node, inputs[1].node, condition, node->join_type);
+        res.positions = inputs[0].positions;
+        for (auto pos : inputs[1].positions) {
+          res.positions.push_back(inputs[0].node->size() + pos);
+        }
+        break;
+      }
+    }
+
+    nodes_.push_back(res.node);
+    built_.emplace(node.get(), res);
+    return res;
+  }
+
+  // Add a projection of the visible columns.
+  BuiltNode project(const BuiltNode& input, const std::vector<std::string>& fields) {
+    std::vector<std::unique_ptr<const RexScalar>> exprs;
+    for (auto pos : input.positions) {
+      exprs.push_back(std::make_unique<RexInput>(input.node.get(), pos));
+    }
+    BuiltNode res;
+    res.node = std::make_shared<RelProject>(exprs, fields, input.node);
+    res.positions = identity(fields.size());
+    nodes_.push_back(res.node);
+    return res;
+  }
+
+  static std::vector<size_t> identity(size_t size) {
+    std::vector<size_t> res(size);
+    for (size_t i = 0; i < size; ++i) {
+      res[i] = i;
+    }
+    return res;
+  }
+
+  // Column references hold an index in the row formed by visible columns of
+  // inputs.
+  std::unique_ptr<const RexScalar> makeRex(const BuilderExpr& expr,
+                                           const std::vector<BuiltNode>& inputs) {
+    switch (expr.kind_) {
+      case BuilderExpr::Kind::kColumnRef: {
+        size_t idx = expr.col_idx_;
+        for (auto& input : inputs) {
+          if (idx < input.positions.size()) {
+            return std::make_unique<RexInput>(input.node.get(), input.positions[idx]);
+          }
+          idx -= input.positions.size();
+        }
+        throw std::runtime_error("Column index is out of range: " +
+                                 std::to_string(expr.col_idx_));
+      }
+      case BuilderExpr::Kind::kLiteral:
+        return makeLiteral(expr);
+      case BuilderExpr::Kind::kOperator: {
+        std::vector<std::unique_ptr<const RexScalar>> operands;
+        for (auto& operand : expr.operands_) {
+          operands.push_back(makeRex(operand, inputs));
+        }
+        return std::make_unique<RexOperator>(expr.op_, operands, expr.type_);
+      }
+      case BuilderExpr::Kind::kAggregate:
+        break;
+    }
+    throw std::runtime_error("Unexpected aggregate expression: " + expr.name_);
+  }
+
+  // Literal scale and precision follow what Calcite reports for SQL literals.
+  std::unique_ptr<const RexScalar> makeLiteral(const BuilderExpr& expr) {
+    auto type = expr.type_.get_type();
+    if (auto val = std::get_if<int64_t>(&expr.value_)) {
+      unsigned precision = std::to_string(*val).size() - (*val < 0 ? 1 : 0);
+      unsigned type_precision = type == kINT ? 10 : 19;
+      return std::make_unique<RexLiteral>(
+          *val, type, type, 0, precision, 0, type_precision);
+    }
+    if (auto val = std::get_if<double>(&expr.value_)) {
+      return std::make_unique<RexLiteral>(*val, kDOUBLE, kDOUBLE, 0, 15, 0, 15);
+    }
+    if (auto val = std::get_if<bool>(&expr.value_)) {
+      return std::make_unique<RexLiteral>(*val, kBOOLEAN, kBOOLEAN, 0, 1, 0, 1);
+    }
+    if (auto val = std::get_if<std::string>(&expr.value_)) {
+      unsigned len = val->size();
+      return std::make_unique<RexLiteral>(*val, kTEXT, kTEXT, 0, len, 0, len);
+    }
+    return std::make_unique<RexLiteral>(type);
+  }
+
+  std::vector<std::shared_ptr<RelAlgNode>> nodes_;
+  std::unordered_map<const BuilderNodeData*, BuiltNode> built_;
+};
+
+/**
+ * RelAlgDag over nodes created by RelAlgNodeFactory. Applies the DAG rewrites
+ * RelAlgDagBuilder runs for parsed queries that don't depend on the JSON
+ * input. Nodes are not coalesced into compound nodes, so each of them is
+ * executed as a separate step.
+ */
+class BuiltRelAlgDag : public RelAlgDag {
+ public:
+  BuiltRelAlgDag(std::vector<std::shared_ptr<RelAlgNode>> nodes) {
+    nodes_ = std::move(nodes);
+    eliminate_identical_copy(nodes_);
+    eliminate_dead_columns(nodes_);
+    create_left_deep_join(nodes_);
+  }
+};
+
+}  // namespace detail
+
+QueryBuilder::QueryBuilder(SchemaProviderPtr schema_provider, int db_id)
+    : schema_provider_(std::move(schema_provider)), db_id_(db_id) {}
+
+BuilderNode QueryBuilder::scan(const std::string& table_name) const {
+  auto table_info = schema_provider_->getTableInfo(db_id_, table_name);
+  if (!table_info) {
+    throw std::runtime_error("Unknown table: " + table_name);
+  }
+  auto node = makeNode(detail::NodeKind::kScan, {});
+  node->table_info = table_info;
+  node->column_infos = schema_provider_->listColumns(db_id_, table_info->table_id);
+  for (auto& col_info : node->column_infos) {
+    if (!col_info->is_rowid) {
+      node->fields.push_back(col_info->name);
+      node->types.push_back(col_info->type);
+    }
+  }
+  return BuilderNode(node);
+}
+
+std::unique_ptr<RelAlgDag> QueryBuilder::finalize(const BuilderNode& root) const {
+  if (!root.node_) {
+    throw std::runtime_error("Uninitialized query builder node");
+  }
+  return std::make_unique<detail::BuiltRelAlgDag>(
+      detail::RelAlgNodeFactory().build(root.node_));
+}
+
+}  // namespace hdk
@@ -0,0 +1,183 @@
+/**
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "SchemaMgr/SchemaProvider.h"
+#include "Shared/sqldefs.h"
+#include "Shared/sqltypes.h"
+
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+class RelAlgDag;
+
+namespace hdk {
+
+namespace detail {
+
+struct BuilderNodeData;
+class RelAlgNodeFactory;
+
+}  // namespace detail
+
+/**
+ * Scalar or aggregate expression used to build a query with QueryBuilder.
+ * Column references are bound to the node they were taken from and are
+ * resolved against node inputs when the expression is used.
+ */
+class BuilderExpr {
+ public:
+  BuilderExpr();
+
+  static BuilderExpr cst(int val);
+  static BuilderExpr cst(int64_t val);
+  static BuilderExpr cst(double val);
+  static BuilderExpr cst(bool val);
+  static BuilderExpr cst(const std::string& val);
+  static BuilderExpr cst(const char* val);
+  static BuilderExpr nullCst(const SQLTypeInfo& type);
+  static BuilderExpr countStar();
+
+  const std::string& name() const { return name_; }
+  const SQLTypeInfo& type() const { return type_; }
+  bool isAggregate() const { return kind_ == Kind::kAggregate; }
+
+  BuilderExpr rename(const std::string& name) const;
+
+  BuilderExpr eq(const BuilderExpr& rhs) const;
+  BuilderExpr ne(const BuilderExpr& rhs) const;
+  BuilderExpr lt(const BuilderExpr& rhs) const;
+  BuilderExpr le(const BuilderExpr& rhs) const;
+  BuilderExpr gt(const BuilderExpr& rhs) const;
+  BuilderExpr ge(const BuilderExpr& rhs) const;
+  BuilderExpr logicalAnd(const BuilderExpr& rhs) const;
+  BuilderExpr logicalOr(const BuilderExpr& rhs) const;
+  BuilderExpr logicalNot() const;
+  BuilderExpr isNull() const;
+  BuilderExpr isNotNull() const;
+
+  BuilderExpr add(const BuilderExpr& rhs) const;
+  BuilderExpr sub(const BuilderExpr& rhs) const;
+  BuilderExpr mul(const BuilderExpr& rhs) const;
+  BuilderExpr div(const BuilderExpr& rhs) const;
+  BuilderExpr mod(const BuilderExpr& rhs) const;
+  BuilderExpr cast(const SQLTypeInfo& type) const;
+
+  BuilderExpr count(bool is_distinct = false) const;
+  BuilderExpr sum() const;
+  BuilderExpr avg() const;
+  BuilderExpr min() const;
+  BuilderExpr max() const;
+
+ private:
+  friend class BuilderNode;
+  friend class detail::RelAlgNodeFactory;
+
+  enum class Kind { kColumnRef, kLiteral, kOperator, kAggregate };
+  using LiteralValue = std::variant<std::monostate, int64_t, double, bool, std::string>;
+
+  BuilderExpr(Kind kind, const SQLTypeInfo& type, const std::string& name);
+
+  BuilderExpr cmpOp(SQLOps op, const BuilderExpr& rhs) const;
+  BuilderExpr logicalOp(SQLOps op, const BuilderExpr& rhs) const;
+  BuilderExpr arithOp(SQLOps op, const BuilderExpr& rhs) const;
+  BuilderExpr unaryOp(SQLOps op, const SQLTypeInfo& type) const;
+  BuilderExpr aggregate(SQLAgg agg,
+                        const std::string& agg_name,
+                        const SQLTypeInfo& type,
+                        bool is_distinct) const;
+
+  Kind kind_;
+  SQLTypeInfo type_;
+  std::string name_;
+  // Column reference: id of the source node and column index in it. Resolved
+  // references have node_id_ set to -1 and hold an index in the input row.
+  int node_id_;
+  size_t col_idx_;
+  // Literal value. std::monostate is used for NULL literals.
+  LiteralValue value_;
+  // Operator or aggregate kind.
+  SQLOps op_;
+  SQLAgg agg_;
+  bool is_distinct_;
+  std::vector<BuilderExpr> operands_;
+};
+
+struct BuilderSortField {
+  // By default, NULLs are sorted as the largest values like in SQL, i.e. last
+  // in ascending order and first in descending order.
+  BuilderSortField(const BuilderExpr& col, bool ascending = true)
+      : col(col), ascending(ascending), nulls_first(!ascending) {}
+  BuilderSortField(const BuilderExpr& col, bool ascending, bool nulls_first)
+      : col(col), ascending(ascending), nulls_first(nulls_first) {}
+
+  BuilderExpr col;
+  bool ascending;
+  bool nulls_first;
+};
+
+/**
+ * Relational algebra node of a query built with QueryBuilder. Nodes are
+ * immutable and can be shared by multiple queries. Output column names are
+ * unique, duplicates get a numeric suffix, e.g. "expr", "expr_1".
+ */
+class BuilderNode {
+ public:
+  BuilderNode();
+
+  size_t size() const;
+  const std::vector<std::string>& fieldNames() const;
+  BuilderExpr ref(size_t col_idx) const;
+  BuilderExpr ref(const std::string& col_name) const;
+
+  BuilderNode proj(const std::vector<BuilderExpr>& exprs) const;
+  BuilderNode filter(const BuilderExpr& condition) const;
+  BuilderNode agg(const std::vector<BuilderExpr>& group_keys,
+                  const std::vector<BuilderExpr>& aggs) const;
+  BuilderNode sort(const std::vector<BuilderSortField>& fields,
+                   size_t limit = 0,
+                   size_t offset = 0) const;
+  BuilderNode join(const BuilderNode& rhs,
+                   const BuilderExpr& condition,
+                   JoinType join_type = JoinType::INNER) const;
+
+ private:
+  friend class QueryBuilder;
+
+  BuilderNode(std::shared_ptr<const detail::BuilderNodeData> node);
+
+  const detail::BuilderNodeData& data() const;
+  // Replace column references with indexes in the row formed by inputs.
+  static BuilderExpr resolve(
+      const BuilderExpr& expr,
+      const std::vector<std::shared_ptr<const detail::BuilderNodeData>>& inputs);
+
+  std::shared_ptr<const detail::BuilderNodeData> node_;
+};
+
+/**
+ * Builds RelAlgDag for queries constructed through the C++ API, skipping SQL
+ * parsing and optimization in Calcite. RelAlg nodes and their expressions are
+ * created directly from built nodes, no relational algebra JSON is produced
+ * or parsed. Scans don't expose the rowid column.
+ */
+class QueryBuilder {
+ public:
+  QueryBuilder(SchemaProviderPtr schema_provider, int db_id);
+
+  BuilderNode scan(const std::string& table_name) const;
+
+  std::unique_ptr<RelAlgDag> finalize(const BuilderNode& root) const;
+
+ private:
+  SchemaProviderPtr schema_provider_;
+  int db_id_;
+};
+
+}  // namespace hdk